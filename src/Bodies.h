@@ -0,0 +1,155 @@
+#pragma once
+#include "Entity.h"
+#include "raylib.h"
+#include <cstddef>
+#include <vector>
+
+// bits of BodyTable::flags
+enum BodyFlags : unsigned char
+{
+    BODY_ACTIVE = 1,  // not destroyed, the same as the entity's IsActive()
+    BODY_PARKED = 2,  // enemies: left out of ticks by the sim LOD
+    BODY_MOVING = 4,  // projectiles: lancer bullets only start flying once they've spawned at the gun
+    BODY_IN_PLAY = 8, // was there for this tick's collision pass, see MarkInPlay()
+};
+
+/* Component storage for everything that moves, one table for the enemies and one for the projectiles (in GameState).
+ * Every component is a column of its own and row i of every column is the same entity,
+ * the movement and collision systems (Systems.cpp) go down these flat arrays instead of visiting an object per entity.
+ * Position, velocity and radius only live in here, the Enemy / Projectile keeps its row (Entity::body) and goes through it.
+ * Status effects, path following, health and drawing are still in the classes.
+ *
+ * Rows are in the order the entities were made, the same order entities has them in and snapshots save them in,
+ * so a loaded or rewound game goes through them in the same order the first run did.
+ * Remove() only clears the row, Compact() closes the gaps (keeping the order) before the next pass over them.
+ */
+class BodyTable
+{
+  public:
+    // transform
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> last_x; // where it was before this tick's move, collisions are swept from here
+    std::vector<float> last_y;
+    // velocity
+    std::vector<float> vel_x;
+    std::vector<float> vel_y;
+    // collider
+    std::vector<float> radius;
+    // projectiles: where it was fired from, it's taken off once it's further away than sqrt(range_sqr), enemies leave these at 0
+    std::vector<float> start_x;
+    std::vector<float> start_y;
+    std::vector<float> range_sqr;
+    // enemies: Enemy::id, what projectiles remember them by, projectiles leave it at 0
+    std::vector<unsigned long long> id;
+    std::vector<unsigned char> flags;
+    std::vector<Entity *> owner; // nullptr once the entity is gone, until Compact()
+
+    // a new row at the end, for an entity that's being made
+    size_t Add(Entity *entity, unsigned char rowFlags = BODY_ACTIVE)
+    {
+        x.push_back(0.0f);
+        y.push_back(0.0f);
+        last_x.push_back(0.0f);
+        last_y.push_back(0.0f);
+        vel_x.push_back(0.0f);
+        vel_y.push_back(0.0f);
+        radius.push_back(0.0f);
+        start_x.push_back(0.0f);
+        start_y.push_back(0.0f);
+        range_sqr.push_back(0.0f);
+        id.push_back(0);
+        flags.push_back(rowFlags);
+        owner.push_back(entity);
+        return owner.size() - 1;
+    }
+    void Remove(size_t row)
+    {
+        owner[row] = nullptr;
+        flags[row] = 0;
+        dead++;
+    }
+    // drops the removed rows, everyone after one moves up and gets told its new row
+    void Compact()
+    {
+        if (dead == 0)
+            return;
+        size_t kept = 0;
+        for (size_t i = 0; i < owner.size(); i++)
+        {
+            if (!owner[i])
+                continue;
+            if (kept != i)
+            {
+                x[kept] = x[i];
+                y[kept] = y[i];
+                last_x[kept] = last_x[i];
+                last_y[kept] = last_y[i];
+                vel_x[kept] = vel_x[i];
+                vel_y[kept] = vel_y[i];
+                radius[kept] = radius[i];
+                start_x[kept] = start_x[i];
+                start_y[kept] = start_y[i];
+                range_sqr[kept] = range_sqr[i];
+                id[kept] = id[i];
+                flags[kept] = flags[i];
+                owner[kept] = owner[i];
+                owner[kept]->body = kept;
+            }
+            kept++;
+        }
+        x.resize(kept);
+        y.resize(kept);
+        last_x.resize(kept);
+        last_y.resize(kept);
+        vel_x.resize(kept);
+        vel_y.resize(kept);
+        radius.resize(kept);
+        start_x.resize(kept);
+        start_y.resize(kept);
+        range_sqr.resize(kept);
+        id.resize(kept);
+        flags.resize(kept);
+        owner.resize(kept);
+        dead = 0;
+    }
+    size_t size() const { return owner.size(); }
+
+    /* everyone active (and not parked) right now is part of this tick's collision pass, anything made after this isn't,
+     * and what gets destroyed after this still is, the same as the lists SimulateTick sorts entities into
+     */
+    void MarkInPlay()
+    {
+        for (size_t i = 0; i < flags.size(); i++)
+        {
+            if ((flags[i] & (BODY_ACTIVE | BODY_PARKED)) == BODY_ACTIVE)
+                flags[i] |= BODY_IN_PLAY;
+            else
+                flags[i] &= ~BODY_IN_PLAY;
+        }
+    }
+
+    Vector2 Position(size_t row) const { return {x[row], y[row]}; }
+    Vector2 Velocity(size_t row) const { return {vel_x[row], vel_y[row]}; }
+    Vector2 LastPosition(size_t row) const { return {last_x[row], last_y[row]}; }
+    void SetPosition(size_t row, Vector2 pos)
+    {
+        x[row] = pos.x;
+        y[row] = pos.y;
+    }
+    void SetVelocity(size_t row, Vector2 vel)
+    {
+        vel_x[row] = vel.x;
+        vel_y[row] = vel.y;
+    }
+    void SetFlag(size_t row, unsigned char flag, bool on)
+    {
+        if (on)
+            flags[row] |= flag;
+        else
+            flags[row] &= ~flag;
+    }
+
+  private:
+    size_t dead = 0; // removed rows still in the columns
+};
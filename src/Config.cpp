@@ -1,6 +1,8 @@
 #include "Config.h"
 #include "Particles.h"
 #include "StatsManager.h"
+#include "DamageEvents.h"
+#include "HealthBars.h"
 #include <raylib.h>
 // initial screen dimensions
 int screenWidth = 1200;
@@ -22,14 +24,6 @@ const Color buildableColor = Color{80, 80, 80, 255};
 const Color gridLineColor = Color{60, 60, 60, 100}; // colour of border of each tile
 const Color mouseHoverColor = Color{100, 255, 100, 50};
 
-// players
-int player_health = 10; // max enemies that can cross u
-int playerMoney = 250; // money u start with
-float enemy_health_multiplier = 1.0f; // makes enemies beefier each stage
-int enemies_killed = 0;
-StatsManager stat_manager; 
-
-
 // turret costs
 const int duo_turret_cost = 100;
 const int ripple_turret_cost = 400;    // t2 duo
@@ -50,19 +44,41 @@ const int poly_enemy_reward = 20;
 const int locus_enemy_reward = 40;
 const int antumbra_enemy_reward = 1000; // big money for big boss
 
-// targets
-// has been declared here because of some (possible?) use in other files, otherwise is local to the enemy class and is used there only.
-std::vector<Vector2> targets;
-Vector2 startPos;
+const float coverage_full_dps = 100.0f;
+bool turret_sleep = true;
+bool fast_forward = true;
+bool sim_lod = true;
+const int sim_lod_max_ticks = 30;
+const float sim_lod_max_dt = 0.04f;
+const char *map_file = "maps/default.ozm";
+const char *telemetry_file = nullptr;
+int metrics_port = 0;
 
 /* TILE SYSTEM CONSTANTS
- * the GRID_COLS variable is fine tuned to the layout of the map
+ * the GRID_COLS variable is fine tuned to the layout of the screen (side panel) and the built-in map
  * Always change it in multiples of 3.
- * Keep adding 3 basically, other than that, the map will be faulty
+ * Keep adding 3 basically, other than that, the built-in map will be faulty
+ * maps loaded from a file have their own size, up to MAP_MAX_SIZE each way
  */
 const int GRID_ROWS = 14;
 const int GRID_COLS = 21;
 const float TILE_SIZE = 40.0f;
+const int MAP_MAX_SIZE = 256;
+
+// camera controls
+const float camera_min_zoom = 0.5f;
+const float camera_max_zoom = 3.0f;
+const float camera_pan_speed = 500.0f; // pixels per second at zoom 1
+
+// rewind buffer
+const size_t rewind_budget_bytes = 64u << 20; // 64 MB, oldest keyframes go first past this
+const int rewind_snapshot_interval = 30;      // ticks between snapshots, half a second at 60 fps
+const int rewind_keyframe_every = 10;         // 1 whole snapshot, then 9 deltas against it
+
+// game speed
+const float sim_time_budget = 0.008f;      // seconds of simulation per rendered frame, past this the speed drops instead of the fps
+const float resolve_tick_dt = 1.0f / 60.0f; // instant resolve steps like a 60 fps game
+const int resolve_max_ticks = 60 * 60 * 15; // 15 minutes of game time, in case a wave never ends
 
 // ---- CONSTANTS FOR ENEMIES ----
 // for flare_enemy
@@ -98,17 +114,20 @@ const float antumbra_enemy_speed = 50.0f;    // Slower than Locus
 const float antumbra_enemy_radius = 32.0f;   // Larger radius
 // ---- ----
 
-// particle system
-ParticleSystem particles;
+// health bars, flushed after all enemy sprites are drawn
+HealthBarBatch health_bars;
+// 1 MB is a lot more than the per-tick lists need even in late waves, overflows show up in the debug line
+thread_local FrameArena frame_arena(1 << 20);
+HeapFrameStats heap_stats;
 
 /* ---- CONSTANTS FOR TURRETS AND PROJECTILES ----
  * DISCLAIMER FOR CONSTANT RELATIONS
  * duo_turret -> normal_bullet
  * lancer_turret -> laser_bullet
- * ripple_turret -> flame_bullet
+ * ripple_turret -> flame stream
  * smite_turret -> shotgun_bullet
  * cyclone_turret -> cyclone_beam
- * salvo_turret -> ice_stream
+ * salvo_turret -> ice stream
  * 
  */
 // duo turret
@@ -145,6 +164,7 @@ const float wave_turret_cooldown_time = 5.0f;
 const float salvo_turret_fire_rate = ripple_turret_fire_rate;
 const float salvo_turret_range = wave_turret_range * 1.5f;
 /* Projectiles */
+const float projectile_max_range_sqr = 1 << 20; // 1024 px
 // normal
 const float normal_bullet_speed = 400.0f;
 const float normal_bullet_damage = 5.0f;
@@ -168,6 +188,15 @@ const float ice_stream_damage = 0.1f; // damage per projectile
 const float ice_stream_speed = flame_bullet_speed * 1.5f; // faster than flames
 const float ice_stream_spread = 5.0f; // degrees
 
+/* streams
+ * ripple and salvo used to spawn a projectile every frame (fire rate 1000, capped by the frame rate, so 60 shots/s),
+ * each one hitting a single enemy at GetDamageFalloff(..., 1) = 2/3 of its damage.
+ * Now they're a cone that deals the same average damage per second, split between everything inside it.
+ */
+const float stream_shots_per_second = 60.0f;
+const float ripple_stream_dps = stream_shots_per_second * flame_bullet_damage / 1.5f; // 40
+const float salvo_stream_dps = stream_shots_per_second * ice_stream_damage / 1.5f;    // 4
+
 // helpers
 const float max_heal_cooldown = 1.0f; // how often the poly heals
 // it's in seconds btw
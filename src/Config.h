@@ -3,6 +3,13 @@
 #include <raylib.h>
 #include "Types.h"
 #include "StatsManager.h"
+#include "DamageEvents.h"
+#include "HealthBars.h"
+#include "EnemyTable.h"
+#include "FrameArena.h"
+#include "FlowField.h"
+#include "CoverageMap.h"
+#include "HeapCounter.h"
 #include <vector>
 
 class StatsManager; // Forward declaration
@@ -26,22 +33,44 @@ extern const Color buildableColor;
 extern const Color gridLineColor;
 extern const Color mouseHoverColor;
 
-// path followed by enemy
-extern std::vector<Vector2> targets;
-extern Vector2 startPos;
-
-// player
-extern int player_health;
-extern int playerMoney;
-extern float enemy_health_multiplier;
-extern int enemies_killed; 
-extern StatsManager stat_manager;
-
+// paths followed by enemies, filled by the map when it loads
+// start is the spawn tile, waypoints are the corners after it, the last one is past the exit
+struct EnemyPath
+{
+    Vector2 start;
+    std::vector<Vector2> waypoints;
+};
+// the paths themselves, the flow field, the coverage map and the player are per game, in GameState
+extern const float coverage_full_dps; // heatmap is fully red at this much dps
+extern bool turret_sleep;             // turrets with no enemy on their stretches of path skip targeting
+extern bool fast_forward;             // ticks where nothing can interact skip straight through (GameState.cpp)
+extern bool sim_lod;                  // enemies far from every turret's reach are left out of ticks and caught up later (GameState.cpp)
+extern const int sim_lod_max_ticks;   // longest an enemy stays left out before it's caught up anyway
+extern const float sim_lod_max_dt;    // ticks longer than this catch everyone up, bullets could cover more than the margin
+extern const char *map_file; // loaded when the game scene starts, main.cpp takes --map <file>
+extern const char *telemetry_file; // gameplay event log (Telemetry.h), none unless main.cpp gets --telemetry <file>
+extern int metrics_port;           // local Prometheus endpoint (Metrics.h), off (0) unless main.cpp gets --metrics <port>
+
+// camera
+extern const float camera_min_zoom;
+extern const float camera_max_zoom;
+extern const float camera_pan_speed;
+
+// rewind
+extern const size_t rewind_budget_bytes;
+extern const int rewind_snapshot_interval;
+extern const int rewind_keyframe_every;
+
+// game speed
+extern const float sim_time_budget;
+extern const float resolve_tick_dt;
+extern const int resolve_max_ticks;
 
 // map constants
 extern const float TILE_SIZE; // Each tile is NxN pixels
-extern const int GRID_COLS;
+extern const int GRID_COLS;   // play area on screen (and the built-in map), the side panel starts right of it
 extern const int GRID_ROWS;
+extern const int MAP_MAX_SIZE; // biggest rows / cols a map file can have
 
 // constants for enemies
 // for flare_enemy
@@ -81,8 +110,12 @@ extern const float locus_enemy_health;
 extern const float antumbra_enemy_radius;
 extern const float antumbra_enemy_speed;
 extern const float antumbra_enemy_health;
-// particles
-extern ParticleSystem particles;
+// enemy health bars, collected while drawing and flushed once
+extern HealthBarBatch health_bars;
+// scratch memory for one frame, reset in main.cpp after EndDrawing()
+// one per thread, every thread running a game resets its own
+extern thread_local FrameArena frame_arena;
+extern HeapFrameStats heap_stats;
 // TURRETS
 // PROJECTILE TURRETS
 // duo turret
@@ -129,6 +162,7 @@ extern const float wave_turret_range;
 extern const float salvo_turret_range;
 extern const float salvo_turret_fire_rate;
 // projectiles
+extern const float projectile_max_range_sqr; // bullets are gone this far (squared) from where they were fired
 // normal bullet
 extern const float normal_bullet_speed;
 extern const float normal_bullet_damage;
@@ -150,6 +184,10 @@ extern const float cyclone_beam_damage;
 extern const float ice_stream_speed;
 extern const float ice_stream_damage;
 extern const float ice_stream_spread; 
+// ripple / salvo stream cones
+extern const float stream_shots_per_second;
+extern const float ripple_stream_dps;
+extern const float salvo_stream_dps;
 
 // helper
 extern const float max_heal_cooldown;
@@ -0,0 +1,199 @@
+#include "CoverageMap.h"
+#include "Config.h"
+#include <algorithm>
+#include <cmath>
+
+void CoverageMap::Reset(int newRows, int newCols, float tileSize)
+{
+    rows = newRows;
+    cols = newCols;
+    tile_size = tileSize;
+    dps.assign(rows * cols, 0.0f);
+    slows.assign(rows * cols, 0);
+    segments.clear();
+    tile_segment_start.assign(rows * cols + 1, 0);
+    tile_segments.clear();
+    last_update_tiles = 0;
+}
+
+void CoverageMap::Clear()
+{
+    std::fill(dps.begin(), dps.end(), 0.0f);
+    std::fill(slows.begin(), slows.end(), 0);
+    for (Segment &segment : segments)
+    {
+        segment.dps = 0.0f;
+        segment.slowed = 0;
+    }
+    last_update_tiles = 0;
+}
+
+/* averages over a whole fire cycle, assuming every shot lands
+ * smite counts all 10 pellets, beams count beam time against cooldown
+ */
+float CoverageMap::NominalDps(TurretType type)
+{
+    switch (type)
+    {
+    case TurretType::DUO:
+        return duo_turret_fire_rate * normal_bullet_damage;
+    case TurretType::RIPPLE:
+        return ripple_stream_dps;
+    case TurretType::SMITE:
+        return smite_turret_fire_rate * 10 * shotgun_bullet_damage;
+    case TurretType::LANCER:
+        return lancer_turret_fire_rate * lancer_bullet_damage;
+    case TurretType::CYCLONE:
+        return cyclone_beam_damage / (cyclone_turret_beam_timer + cyclone_turret_cooldown_timer);
+    case TurretType::MELTDOWN:
+        return meltdown_turret_dps * meltdown_turret_beam_timer / (meltdown_turret_beam_timer + meltdown_turret_cooldown_timer);
+    case TurretType::WAVE:
+        return 0.0f;
+    case TurretType::SALVO:
+        return salvo_stream_dps;
+    }
+    return 0.0f;
+}
+
+float CoverageMap::NominalRange(TurretType type)
+{
+    switch (type)
+    {
+    case TurretType::DUO:
+        return duo_turret_range;
+    case TurretType::RIPPLE:
+        return ripple_turret_range;
+    case TurretType::SMITE:
+        return smite_turret_range;
+    case TurretType::LANCER:
+        return lancer_turret_range;
+    case TurretType::CYCLONE:
+        return cyclone_turret_range;
+    case TurretType::MELTDOWN:
+        return meltdown_turret_range;
+    case TurretType::WAVE:
+        return wave_turret_range;
+    case TurretType::SALVO:
+        return salvo_turret_range;
+    }
+    return 0.0f;
+}
+
+bool CoverageMap::Slows(TurretType type)
+{
+    return type == TurretType::WAVE || type == TurretType::SALVO;
+}
+
+// a tile is covered when its middle is in range, only the square around the turret is looked at
+void CoverageMap::Apply(TurretType type, Vector2 pos, float range, int sign)
+{
+    float amount = sign * NominalDps(type);
+    bool slowing = Slows(type);
+    int firstRow = std::max(0, (int)floorf((pos.y - range) / tile_size));
+    int lastRow = std::min(rows - 1, (int)floorf((pos.y + range) / tile_size));
+    int firstCol = std::max(0, (int)floorf((pos.x - range) / tile_size));
+    int lastCol = std::min(cols - 1, (int)floorf((pos.x + range) / tile_size));
+    last_update_tiles = 0;
+    for (int r = firstRow; r <= lastRow; r++)
+    {
+        for (int c = firstCol; c <= lastCol; c++)
+        {
+            float dx = c * tile_size + tile_size / 2 - pos.x;
+            float dy = r * tile_size + tile_size / 2 - pos.y;
+            if (dx * dx + dy * dy > range * range)
+                continue;
+            int index = r * cols + c;
+            dps[index] += amount;
+            // float sums drift, an empty tile should read exactly 0
+            if (dps[index] < 0.001f)
+                dps[index] = 0.0f;
+            // slowed only changes for the segments when the tile goes from 0 slows to 1 or back
+            bool slowedBefore = slows[index] > 0;
+            slows[index] += slowing ? sign : 0;
+            int slowedChange = (slows[index] > 0) - slowedBefore;
+            for (int i = tile_segment_start[index]; i < tile_segment_start[index + 1]; i++)
+            {
+                Segment &segment = segments[tile_segments[i]];
+                segment.dps += amount;
+                if (segment.dps < 0.001f)
+                    segment.dps = 0.0f;
+                segment.slowed += slowedChange;
+            }
+            last_update_tiles++;
+        }
+    }
+}
+
+void CoverageMap::BuildSegments(const std::vector<EnemyPath> &paths)
+{
+    segments.clear();
+    // (tile, segment) pairs first, then counted into the CSR arrays
+    std::vector<std::pair<int, int>> pairs;
+    for (int p = 0; p < (int)paths.size(); p++)
+    {
+        Vector2 from = paths[p].start;
+        for (int w = 0; w < (int)paths[p].waypoints.size(); w++)
+        {
+            Vector2 to = paths[p].waypoints[w];
+            Segment segment = {p, w, 0.0f, 0, 0};
+            int segmentIndex = (int)segments.size();
+            // waypoints are tile middles on one row or one column, so this steps tile by tile
+            int steps = (int)roundf(fmaxf(fabsf(to.x - from.x), fabsf(to.y - from.y)) / tile_size);
+            for (int s = 0; s <= steps; s++)
+            {
+                float t = steps ? (float)s / steps : 0.0f;
+                int c = (int)floorf((from.x + (to.x - from.x) * t) / tile_size);
+                int r = (int)floorf((from.y + (to.y - from.y) * t) / tile_size);
+                if (r < 0 || c < 0 || r >= rows || c >= cols)
+                    continue; // the step past the exit
+                int index = r * cols + c;
+                pairs.push_back({index, segmentIndex});
+                segment.dps += dps[index];
+                segment.slowed += slows[index] > 0;
+                segment.tiles++;
+            }
+            segments.push_back(segment);
+            from = to;
+        }
+    }
+    std::fill(tile_segment_start.begin(), tile_segment_start.end(), 0);
+    for (auto &pair : pairs)
+    {
+        tile_segment_start[pair.first + 1]++;
+    }
+    for (int i = 0; i < rows * cols; i++)
+    {
+        tile_segment_start[i + 1] += tile_segment_start[i];
+    }
+    tile_segments.assign(pairs.size(), 0);
+    std::vector<int> fill(tile_segment_start.begin(), tile_segment_start.end() - 1);
+    for (auto &pair : pairs)
+    {
+        tile_segments[fill[pair.first]++] = pair.second;
+    }
+}
+
+void CoverageMap::Draw(const Rectangle &view) const
+{
+    int firstRow = std::max(0, (int)floorf(view.y / tile_size));
+    int lastRow = std::min(rows - 1, (int)floorf((view.y + view.height) / tile_size));
+    int firstCol = std::max(0, (int)floorf(view.x / tile_size));
+    int lastCol = std::min(cols - 1, (int)floorf((view.x + view.width) / tile_size));
+    for (int r = firstRow; r <= lastRow; r++)
+    {
+        for (int c = firstCol; c <= lastCol; c++)
+        {
+            int index = r * cols + c;
+            if (dps[index] <= 0.0f && !slows[index])
+                continue;
+            Rectangle rect = {c * tile_size, r * tile_size, tile_size, tile_size};
+            if (dps[index] > 0.0f)
+            {
+                float strength = fminf(dps[index] / coverage_full_dps, 1.0f);
+                DrawRectangleRec(rect, Color{230, 41, 55, (unsigned char)(40 + 140 * strength)});
+            }
+            if (slows[index])
+                DrawRectangleLinesEx(rect, 2, Color{102, 191, 255, 200});
+        }
+    }
+}
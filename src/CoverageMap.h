@@ -0,0 +1,63 @@
+#pragma once
+#include "Types.h"
+#include "raylib.h"
+#include <vector>
+
+struct EnemyPath;
+
+/* How much turret fire and slowing reaches every tile, and every stretch of enemy path
+ * Kept up to date one turret at a time: placing adds its nominal dps to the tiles in its range,
+ * selling takes it off again, an upgrade is one of each. Nothing ever loops over all turrets,
+ * so the overlay, build previews and bots can read it every frame for free.
+ * dps is the turret's average on a target that stays in range (see NominalDps), not what it actually dealt.
+ */
+class CoverageMap
+{
+  public:
+    int rows = 0;
+    int cols = 0;
+    float tile_size = 0.0f;
+    std::vector<float> dps;           // per tile, row * cols + col
+    std::vector<unsigned char> slows; // per tile, how many slowing turrets reach it
+
+    /* one segment per straight stretch of enemy_paths (start -> first corner, corner -> corner, ...)
+     * dps is summed over the segment's tiles, divide by an enemy's speed in tiles/s for what it takes walking it
+     * slowed is how many of its tiles at least one slowing turret reaches
+     * corners belong to both segments they join
+     */
+    struct Segment
+    {
+        int path;
+        int index; // waypoint it leads to
+        float dps;
+        int slowed;
+        int tiles;
+    };
+    std::vector<Segment> segments;
+    int last_update_tiles = 0; // tiles the last AddTurret / RemoveTurret touched
+
+    void Reset(int newRows, int newCols, float tileSize);
+    // keeps the segments, drops every turret
+    void Clear();
+    void AddTurret(TurretType type, Vector2 pos, float range) { Apply(type, pos, range, 1); }
+    void RemoveTurret(TurretType type, Vector2 pos, float range) { Apply(type, pos, range, -1); }
+    // after the paths change, the sums are taken from the tiles as they are
+    void BuildSegments(const std::vector<EnemyPath> &paths);
+
+    float DpsAt(int index) const { return dps[index]; }
+    int SlowsAt(int index) const { return slows[index]; }
+
+    // turret stats as the map sees them, the same numbers the build info shows
+    static float NominalDps(TurretType type);
+    static float NominalRange(TurretType type);
+    static bool Slows(TurretType type);
+
+    // heatmap on the tiles inside view, red for damage (full at coverage_full_dps), blue edge for slowing
+    void Draw(const Rectangle &view) const;
+
+  private:
+    // CSR list of the segments going over each tile, tile_segments[tile_segment_start[i] .. tile_segment_start[i + 1])
+    std::vector<int> tile_segment_start;
+    std::vector<int> tile_segments;
+    void Apply(TurretType type, Vector2 pos, float range, int sign);
+};
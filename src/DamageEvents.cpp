@@ -0,0 +1,78 @@
+#include "DamageEvents.h"
+#include "Config.h"
+#include "Enemy.h"
+#include "GameState.h"
+#include <algorithm>
+
+// turret type of a stats slot, TURRET_TYPE_COUNT for -1
+static int SourceType(int source)
+{
+    return source < 0 ? TURRET_TYPE_COUNT : (int)game->stat_manager.turrets[source].type;
+}
+
+void DamageQueue::Resolve()
+{
+    if (events.empty())
+        return;
+
+    // group hits by enemy, keeping the order they happened in
+    std::sort(events.begin(), events.end(), [](const DamageEvent &a, const DamageEvent &b) {
+        if (a.target_id != b.target_id)
+            return a.target_id < b.target_id;
+        return a.order < b.order;
+    });
+
+    float tick_damage = 0.0f;
+    float type_damage[TURRET_TYPE_COUNT + 1] = {}; // only for telemetry, the last one is hits without a turret
+    bool logging = game->telemetry != nullptr;
+    size_t i = 0;
+    while (i < events.size())
+    {
+        Enemy *enemy = events[i].target;
+        size_t group_end = i;
+        while (group_end < events.size() && events[group_end].target == enemy)
+        {
+            group_end++;
+        }
+
+        for (size_t j = i; j < group_end && enemy->IsActive(); j++)
+        {
+            const DamageEvent &hit = events[j];
+            enemy->hp -= hit.amount;
+            tick_damage += hit.amount;
+            game->stat_manager.HitDealt(hit.source, hit.amount);
+            if (logging)
+                type_damage[SourceType(hit.source)] += hit.amount;
+            if (hit.proj_type == ProjectileType::ICE_STREAM)
+            {
+                enemy->status_effect = StatusEffects::SLOWED;
+            }
+
+            if (enemy->hp <= 0)
+            {
+                // if dead, give money, disappear, and make a boom
+                // anything else that hit it this tick is simply wasted
+                game->playerMoney += enemy->kill_reward;
+                game->enemies_killed++;
+                game->stat_manager.EnemyKilled(enemy->GetEnemyType(), hit.source, -enemy->hp);
+                game->Record(TelemetryKind::KILL, enemy->id, -enemy->hp, (int)enemy->GetEnemyType(), SourceType(hit.source));
+                enemy->Destroy();
+                game->particles.SpawnExplosion(enemy->GetPosition(), hit.proj_type);
+            }
+        }
+        // if not dead, just flash white to show it got hit
+        if (enemy->IsActive())
+        {
+            enemy->took_damage = true;
+        }
+        i = group_end;
+    }
+
+    game->stat_manager.DamageDealt(tick_damage);
+    for (int type = 0; logging && type <= TURRET_TYPE_COUNT; type++)
+    {
+        if (type_damage[type] > 0.0f)
+            game->Record(TelemetryKind::DAMAGE, 0, type_damage[type], 0, type);
+    }
+    events.clear();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Types.h"
+#include <vector>
+
+class Enemy; // only ever held by pointer here, resolution lives in DamageEvents.cpp
+
+/* One hit, recorded instead of applied.
+ * Collision loops and beams only push these, they never touch hp, money or stats directly.
+ * That keeps hit detection free of writes to shared state,
+ * so it could be split across threads later (each thread fills its own queue, then Append()).
+ */
+struct DamageEvent
+{
+    Enemy *target;
+    unsigned long long target_id; // sort key, so all hits on one enemy end up next to each other
+    unsigned int order;           // keeps the original hit order within one enemy
+    float amount;
+    ProjectileType proj_type;
+    int source; // StatsManager turret slot of whoever dealt it, -1 if unknown
+};
+
+/* Per-tick buffer of hits
+ * Push() during the update/interaction passes, Resolve() once at the end of the tick.
+ * Resolve sorts by enemy, applies all hits on an enemy in one go,
+ * handles its death exactly once, and hands the tick's damage to the stats in one call.
+ */
+class DamageQueue
+{
+  public:
+    std::vector<DamageEvent> events;
+
+    void Push(Enemy *target, unsigned long long target_id, ProjectileType proj_type, float amount, int source = -1)
+    {
+        events.push_back({target, target_id, (unsigned int)events.size(), amount, proj_type, source});
+    }
+    void Append(const DamageQueue &other)
+    {
+        for (const auto &e : other.events)
+        {
+            Push(e.target, e.target_id, e.proj_type, e.amount, e.source);
+        }
+    }
+    void Resolve();
+    void clear() { events.clear(); }
+};
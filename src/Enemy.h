@@ -1,6 +1,8 @@
 #pragma once
+#include "Bodies.h"
 #include "Config.h"
 #include "Entity.h"
+#include "GameState.h"
 #include "Particles.h"
 #include "raylib.h"
 #include "raymath.h"
@@ -14,7 +16,6 @@ using namespace std;
 class Enemy : public Entity
 {
   public:
-    float radius;
     float speed;
     float original_speed;
     int map_counter = 0;
@@ -27,14 +28,44 @@ class Enemy : public Entity
     int kill_reward;
     StatusEffects status_effect = StatusEffects::NONE;
     float status_timer = 0.0f;
-    Vector2 targetPos = targets[map_counter];
+    int path_index = 0;   // which of enemy_paths this one walks (or which spawn it came from, with the flow field)
+    bool leaving = false; // flow field: headed off the map through an exit, reaching targetPos costs health
+    Vector2 targetPos = {0, 0};
+    /* sim LOD (GameState.cpp): parked (BODY_PARKED on its row) means left out of ticks since parked_since, to be caught up by parked_until on the game clock
+     * never saved, every snapshot is taken with everyone caught up
+     */
+    unsigned long long parked_since = 0;
+    double parked_at = 0.0;
+    double parked_until = 0.0;
     Enemy()
     {
-        id = next_id++;
-        position = startPos;
+        kind = EntityKind::ENEMY;
+        // position, velocity and radius live in the game's enemy table from here on
+        bodies = &game->enemy_bodies;
+        body = bodies->Add(this);
+        id = game->next_enemy_id++;
+        bodies->id[body] = id;
+        // with more than one path (or spawn), enemies take turns
+        if (game->nav_mode == NavMode::FLOW_FIELD && !game->spawn_points.empty())
+        {
+            path_index = game->next_enemy_path++ % (int)game->spawn_points.size();
+            SetPosition(game->spawn_points[path_index]);
+            targetPos = game->flow_field.NextTarget(GetPosition(), Vector2{0, 0}, id, leaving);
+        }
+        else if (!game->enemy_paths.empty())
+        {
+            path_index = game->next_enemy_path++ % (int)game->enemy_paths.size();
+            SetPosition(game->enemy_paths[path_index].start);
+            targetPos = game->enemy_paths[path_index].waypoints[0];
+        }
     }
-    // idea to use multiplier as a fall-off for distance or other factors
-    void TakeDamage(ProjectileType proj_type, float multiplier)
+    ~Enemy() { bodies->Remove(body); }
+    /* idea to use multiplier as a fall-off for distance or other factors
+     * Nothing is applied here, the hit is only recorded in damage_events
+     * and applied when the queue is resolved at the end of the tick (see DamageEvents.cpp)
+     * source => stats slot of the turret responsible, for per-turret stats
+     */
+    void TakeDamage(ProjectileType proj_type, float multiplier, int source = -1)
     {
         // different projectiles deal different damage
         float damage = 0;
@@ -67,60 +98,87 @@ class Enemy : public Entity
         }
         case ProjectileType::ICE_STREAM:
         {
+            // the slow itself is applied on resolve too
             damage = ice_stream_damage * multiplier;
-            if (status_effect != StatusEffects::SLOWED)
-            {
-                status_effect = StatusEffects::SLOWED;
-            }
             break;
         }
         }
 
-        hp -= damage;
-        stat_manager.DamageDealt(damage);
-
-        if (hp <= 0)
-        {
-            // if dead, give money, disappear, and make a boom
-            playerMoney += kill_reward;
-            enemies_killed++;
-            stat_manager.EnemyKilled(GetEnemyType());
-            Destroy();
-            particles.SpawnExplosion(position, proj_type);
-            // Death animation => never implemented :(
-            return;
-        }
-
-        // if not dead, just flash white to show it got hit
-        took_damage = true;
+        game->damage_events.Push(this, id, proj_type, damage, source);
     }
-    void TakeDamageByValue(ProjectileType proj_type, float amount)
+    void TakeDamageByValue(ProjectileType proj_type, float amount, int source = -1)
     {
-        hp -= amount;
-        stat_manager.DamageDealt(amount);
-        if (hp <= 0)
-        {
-            enemies_killed++;
-            stat_manager.EnemyKilled(GetEnemyType());
-            Destroy();
-            playerMoney += kill_reward;
-            particles.SpawnExplosion(position, proj_type);
-        }
-        took_damage = true;
+        game->damage_events.Push(this, id, proj_type, amount, source);
+    }
+    Vector2 GetPosition() const final { return bodies->Position(body); }
+    Vector2 GetVelocity() const final { return bodies->Velocity(body); }
+    void SetPosition(Vector2 pos) final { bodies->SetPosition(body, pos); }
+    void SetVelocity(Vector2 vel) final { bodies->SetVelocity(body, vel); }
+    float GetRadius() const { return bodies->radius[body]; }
+    void SetRadius(float r) { bodies->radius[body] = r; }
+    bool IsParked() const { return bodies->flags[body] & BODY_PARKED; }
+    void SetParked(bool parked) { bodies->SetFlag(body, BODY_PARKED, parked); }
+
+    void Save(BinaryWriter &out) override
+    {
+        Entity::Save(out);
+        out.Write(GetRadius());
+        out.Write(speed);
+        out.Write(original_speed);
+        out.Write(map_counter);
+        out.Write(path_index);
+        out.WriteBool(leaving);
+        out.Write(id);
+        out.Write(hp);
+        out.Write(max_hp);
+        out.WriteBool(took_damage);
+        out.WriteBool(isVisible);
+        out.WriteBool(healed_this_frame);
+        out.Write(kill_reward);
+        out.WriteEnum(status_effect);
+        out.Write(status_timer);
+        out.Write(targetPos);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Entity::Load(in);
+        SetRadius(in.Read<float>());
+        in.Read(speed);
+        in.Read(original_speed);
+        in.Read(map_counter);
+        in.Read(path_index);
+        leaving = in.ReadBool();
+        in.Read(id);
+        bodies->id[body] = id;
+        in.Read(hp);
+        in.Read(max_hp);
+        took_damage = in.ReadBool();
+        isVisible = in.ReadBool();
+        healed_this_frame = in.ReadBool();
+        in.Read(kill_reward);
+        status_effect = in.ReadEnum<StatusEffects>();
+        in.Read(status_timer);
+        in.Read(targetPos);
     }
-    float GetRadius() { return radius; }
-
     /* A simple place-holder function IN-CASE some enemies do actions
     * Don't want to put it in the update function, that handles too many things
     * Most enemies might just have this function empty, and some have something
     * to do in here, like a special ability
     * Update : poly_enemy actually does something
     */
-    virtual void DoEnemyAction(vector<Enemy *> &targets, float deltaTime) {}
+    virtual void DoEnemyAction(FrameVector<Enemy *> &targets, float deltaTime) {}
+    /* for fast-forward: how many ticks of deltaTime (up to limit) DoEnemyAction leaves every other enemy alone
+     * past that it may need to see them, so the game goes back to full ticks
+     */
+    virtual int TicksUntilAction(float deltaTime, int limit) { return limit; }
+    // DoEnemyAction does anything at all, these are never left out by the sim LOD
+    virtual bool HasEnemyAction() const { return false; }
 
+    /* this runs every tick for enemy, after MoveEnemies (Systems.cpp) has moved it
+     * only the status effects are left in here
+     */
     void Update(float deltaTime) override
     {
-        // this runs every frame for enemy
         if (status_effect != StatusEffects::NONE && status_timer <= 0)
         // if enemy has a status effect and its timer isn't running, start it
         {
@@ -168,43 +226,58 @@ class Enemy : public Entity
                 status_timer = 0.0f;
             }
         }
-        if (position.y >= GRID_ROWS * TILE_SIZE)
-        // if enemy reaches the end, u lose health
-        {
-            Destroy();
-            player_health--;
-        }
-        if (position.x >= GRID_COLS * TILE_SIZE || position.y == NAN || position.x == NAN)
-        {
-            // if enemy goes off screen for some reason, just delete it
-            // the NAN check exists only to catch whenever a variable remains uninitialised and crashes the whole thing
-            // Happened a few times and debugging was a nightmare
-            // Realised I can't guarantee existence especially when rolling out new features.
-            Destroy();
-        }
-
-        position.x += velocity.x * deltaTime;
-        position.y += velocity.y * deltaTime;
+        // reaching the end of the path (and losing the player health) is in Update()
     }
     virtual void Draw() override = 0;
     virtual EnemyType GetEnemyType() = 0;
+    /* close enough to targetPos, or walked past it
+     * at 20-30 ticks a second a step is longer than the "close enough" and it would turn round and round the tile middle
+     */
+    bool ReachedTarget() const
+    {
+        Vector2 position = GetPosition();
+        return Vector2DistanceSqr(position, targetPos) < GetRadius() || Vector2DotProduct(GetVelocity(), Vector2Subtract(targetPos, position)) < 0.0f;
+    }
     void Update()
     {
-        // if the enemy is at the last path tile, make it go off screen
-        if (targetPos == targets.back())
+        if (game->nav_mode == NavMode::FLOW_FIELD)
         {
-            targetPos.y += 40;
+            // reached the middle of a tile, one look at the field says where next
+            // no stop in between like at the corners below, that would be a stutter every tile
+            if (ReachedTarget())
+            {
+                if (leaving)
+                // if enemy reaches the end, u lose health
+                {
+                    Destroy();
+                    game->player_health--;
+                    game->Record(TelemetryKind::LEAK, id, 0.0f, (int)GetEnemyType());
+                    return;
+                }
+                targetPos = game->flow_field.NextTarget(targetPos, GetVelocity(), id, leaving);
+            }
+            SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
+            return;
         }
         // if enemy reaches a path corner, update its target to the next corner
-        if (Vector2DistanceSqr(position, targetPos) < radius)
+        if (ReachedTarget())
         {
-            velocity = {0, 0};
+            SetVelocity({0, 0});
             map_counter++;
-            targetPos = targets[map_counter];
+            const std::vector<Vector2> &waypoints = game->enemy_paths[path_index].waypoints;
+            if (map_counter >= (int)waypoints.size())
+            // if enemy reaches the end, u lose health
+            {
+                Destroy();
+                game->player_health--;
+                game->Record(TelemetryKind::LEAK, id, 0.0f, (int)GetEnemyType());
+                return;
+            }
+            targetPos = waypoints[map_counter];
             return;
         }
         // otherwise just keep moving towards the current target
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
 
     void Destroy() override
@@ -212,6 +285,7 @@ class Enemy : public Entity
         if (is_active)
         {
             is_active = false;
+            bodies->SetFlag(body, BODY_ACTIVE, false);
         }
         return;
     }
@@ -300,9 +374,6 @@ class Enemy : public Entity
     // antumbra boss
     inline static Image antumbra_enemyIMG;
     inline static Texture2D antumbra_enemyTX;
-
-  private:
-    static inline unsigned long long next_id = 0;
 };
 
 class flare_enemy : public Enemy
@@ -310,17 +381,19 @@ class flare_enemy : public Enemy
   public:
     flare_enemy()
     {
-        radius = flare_enemy_radius;
+        SetRadius(flare_enemy_radius);
         speed = flare_enemy_speed;
         original_speed = speed;
-        hp = flare_enemy_health * enemy_health_multiplier;
-        max_hp = flare_enemy_health * enemy_health_multiplier;
+        hp = flare_enemy_health * game->enemy_health_multiplier;
+        max_hp = flare_enemy_health * game->enemy_health_multiplier;
         kill_reward = flare_enemy_reward;
         // this one line caused a bug that took me 4 hours to find and fix. I hate u
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
         if (took_damage)
         {
@@ -344,7 +417,7 @@ class flare_enemy : public Enemy
         {
             DrawTexturePro(flare_enemyTX, {0, 0, (float)flare_enemyTX.width, (float)flare_enemyTX.height}, {position.x, position.y, (float)flare_enemyTX.width, (float)flare_enemyTX.height}, {flare_enemyTX.width / 2.0f, flare_enemyTX.height / 2.0f}, rotation, WHITE);
         }
-        DrawHealthBar(hp, max_hp, position);
+        health_bars.Push(hp, max_hp, position);
     }
     EnemyType GetEnemyType() override { return EnemyType::FLARE; }
 };
@@ -354,17 +427,19 @@ class mono_enemy : public Enemy
   public:
     mono_enemy()
     {
-        radius = mono_enemy_radius;
+        SetRadius(mono_enemy_radius);
         speed = mono_enemy_speed;
         original_speed = speed;
-        hp = mono_enemy_health * enemy_health_multiplier;
-        max_hp = mono_enemy_health * enemy_health_multiplier;
+        hp = mono_enemy_health * game->enemy_health_multiplier;
+        max_hp = mono_enemy_health * game->enemy_health_multiplier;
         kill_reward = mono_enemy_reward;
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
 
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
         if (took_damage)
         {
@@ -388,7 +463,7 @@ class mono_enemy : public Enemy
         {
             DrawTexturePro(mono_enemyTX, {0, 0, (float)mono_enemyTX.width, (float)mono_enemyTX.height}, {position.x, position.y, (float)mono_enemyTX.width, (float)mono_enemyTX.height}, {mono_enemyTX.width / 2.0f, mono_enemyTX.height / 2.0f}, rotation, WHITE);
         }
-        DrawHealthBar(hp, max_hp, position);
+        health_bars.Push(hp, max_hp, position);
     }
 
     EnemyType GetEnemyType() override { return EnemyType::MONO; }
@@ -399,23 +474,25 @@ class crawler_enemy : public Enemy
   public:
     crawler_enemy()
     {
-        radius = crawler_enemy_radius;
+        SetRadius(crawler_enemy_radius);
         speed = crawler_enemy_speed;
-        hp = crawler_enemy_health * enemy_health_multiplier;
-        max_hp = crawler_enemy_health * enemy_health_multiplier;
+        hp = crawler_enemy_health * game->enemy_health_multiplier;
+        max_hp = crawler_enemy_health * game->enemy_health_multiplier;
         original_speed = speed;
         kill_reward = crawler_enemy_reward;
         isVisible = false;
 
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
         if (isVisible)
         {
             DrawTexturePro(crawler_enemyTX, {0, 0, (float)crawler_enemyTX.width, (float)crawler_enemyTX.height}, {position.x, position.y, (float)crawler_enemyTX.width, (float)crawler_enemyTX.height}, {crawler_enemyTX.width / 2.0f, crawler_enemyTX.height / 2.0f}, rotation, WHITE);
-            DrawHealthBar(hp, max_hp, position);
+            health_bars.Push(hp, max_hp, position);
         }
         else if (took_damage) // flash white for one frame
         {
@@ -448,21 +525,23 @@ class poly_enemy : public Enemy
 {
   public:
     float range;
-    float heal_cooldown;
+    float heal_cooldown = 0.0f; // was left uninitialised, snapshots need it to be a real value
     poly_enemy()
     {
-        radius = poly_enemy_radius;
+        SetRadius(poly_enemy_radius);
         speed = poly_enemy_speed;
-        hp = poly_enemy_health * enemy_health_multiplier;
-        max_hp = poly_enemy_health * enemy_health_multiplier;
+        hp = poly_enemy_health * game->enemy_health_multiplier;
+        max_hp = poly_enemy_health * game->enemy_health_multiplier;
         original_speed = speed;
         kill_reward = poly_enemy_reward;
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
         range = 3.0f * TILE_SIZE;
     }
 
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
 
         if (took_damage) // flash white for one frame
@@ -481,19 +560,20 @@ class poly_enemy : public Enemy
         {
             DrawTexturePro(poly_enemyTX, {0, 0, (float)poly_enemyTX.width, (float)poly_enemyTX.height}, {position.x, position.y, (float)poly_enemyTX.width, (float)poly_enemyTX.height}, {poly_enemyTX.width / 2.0f, poly_enemyTX.height / 2.0f}, rotation, WHITE);
         }
-        DrawHealthBar(hp, max_hp, position);
+        health_bars.Push(hp, max_hp, position);
     }
     /* Healer action implementation
      * Loops through all enemies, and heals any that are within range and not full health (at once)
      * Has a cooldown
      */
-    void DoEnemyAction(vector<Enemy *> &targets, float deltaTime) override
+    void DoEnemyAction(FrameVector<Enemy *> &targets, float deltaTime) override
     {
         if (heal_cooldown > 0)
         {
             heal_cooldown -= deltaTime;
             return;
         }
+        Vector2 position = GetPosition();
         for (auto &enemy : targets)
         {
             if (enemy->GetEnemyType() != EnemyType::POLY && Vector2DistanceSqr(position, enemy->GetPosition()) <= range * range && enemy->hp < enemy->max_hp)
@@ -512,6 +592,31 @@ class poly_enemy : public Enemy
         // cooldown only after healing everyone possible
         // always tries to heal everyone within range if cooldown is allowing it
     }
+    // counts down exactly like DoEnemyAction does, the tick it reaches 0 is the one that heals
+    int TicksUntilAction(float deltaTime, int limit) override
+    {
+        float cooldown = heal_cooldown;
+        int ticks = 0;
+        while (cooldown > 0 && ticks < limit)
+        {
+            cooldown -= deltaTime;
+            ticks++;
+        }
+        return ticks;
+    }
+    bool HasEnemyAction() const override { return true; }
+    void Save(BinaryWriter &out) override
+    {
+        Enemy::Save(out);
+        out.Write(range);
+        out.Write(heal_cooldown);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Enemy::Load(in);
+        in.Read(range);
+        in.Read(heal_cooldown);
+    }
     EnemyType GetEnemyType() override { return EnemyType::POLY; }
 };
 
@@ -522,16 +627,18 @@ class locus_enemy : public Enemy
   public:
     locus_enemy()
     {
-        radius = locus_enemy_radius;
+        SetRadius(locus_enemy_radius);
         speed = locus_enemy_speed;
         original_speed = speed;
-        hp = locus_enemy_health * enemy_health_multiplier;
-        max_hp = locus_enemy_health * enemy_health_multiplier;
+        hp = locus_enemy_health * game->enemy_health_multiplier;
+        max_hp = locus_enemy_health * game->enemy_health_multiplier;
         kill_reward = locus_enemy_reward;
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
         if (took_damage)
         {
@@ -555,7 +662,7 @@ class locus_enemy : public Enemy
         {
             DrawTexturePro(locus_enemyTX, {0, 0, (float)locus_enemyTX.width, (float)locus_enemyTX.height}, {position.x, position.y, (float)locus_enemyTX.width, (float)locus_enemyTX.height}, {locus_enemyTX.width / 2.0f, locus_enemyTX.height / 2.0f}, rotation, WHITE);
         }
-        DrawHealthBar(hp, max_hp, position);
+        health_bars.Push(hp, max_hp, position);
     }
     EnemyType GetEnemyType() override { return EnemyType::LOCUS; }
 };
@@ -565,16 +672,18 @@ class antumbra_enemy : public Enemy
   public:
     antumbra_enemy()
     {
-        radius = antumbra_enemy_radius;
+        SetRadius(antumbra_enemy_radius);
         speed = antumbra_enemy_speed;
         original_speed = speed;
-        hp = antumbra_enemy_health * enemy_health_multiplier;
-        max_hp = antumbra_enemy_health * enemy_health_multiplier;
+        hp = antumbra_enemy_health * game->enemy_health_multiplier;
+        max_hp = antumbra_enemy_health * game->enemy_health_multiplier;
         kill_reward = antumbra_enemy_reward;
-        velocity = velFromSpeed(position, targetPos, speed);
+        SetVelocity(velFromSpeed(GetPosition(), targetPos, speed));
     }
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG + 90.0f;
         if (took_damage)
         {
@@ -598,7 +707,7 @@ class antumbra_enemy : public Enemy
         {
             DrawTexturePro(antumbra_enemyTX, {0, 0, (float)antumbra_enemyTX.width, (float)antumbra_enemyTX.height}, {position.x, position.y, (float)antumbra_enemyTX.width, (float)antumbra_enemyTX.height}, {antumbra_enemyTX.width / 2.0f, antumbra_enemyTX.height / 2.0f}, rotation, WHITE);
         }
-        DrawHealthBar(hp, max_hp, position);
+        health_bars.Push(hp, max_hp, position);
     }
     EnemyType GetEnemyType() override { return EnemyType::ANTUMBRA; }
 };
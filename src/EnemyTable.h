@@ -0,0 +1,124 @@
+#pragma once
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class Enemy; // only held by pointer, so this header stays usable without the rest of the game
+
+/* Structure-of-arrays copy of what turret targeting needs from every live enemy
+ * Rebuilt once per tick from enemy_ptrs (after movement), then turrets scan these flat float arrays
+ * instead of chasing a pointer per enemy per check (collision goes over GameState::enemy_bodies instead, see Systems.cpp).
+ * Index i in every array is the same enemy, enemy[i] leads back to the object for applying hits.
+ * Anything that changes during the tick (status from the wave turret, deaths) shows up next tick.
+ */
+class EnemyTable
+{
+  public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> radius;
+    std::vector<unsigned char> visible;
+    std::vector<unsigned char> slowed;
+    std::vector<int> path_dist; // flow_field distance of the tile each one is on, -1 if it isn't on the path
+    std::vector<Enemy *> enemy;
+
+    // every path_dist that isn't -1, sorted, and how many were -1, for turrets deciding whether to wake up
+    std::vector<int> sorted_dist;
+    int off_path = 0;
+
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        radius.clear();
+        visible.clear();
+        slowed.clear();
+        path_dist.clear();
+        enemy.clear();
+        sorted_dist.clear();
+        off_path = 0;
+    }
+    void reserve(size_t n)
+    {
+        x.reserve(n);
+        y.reserve(n);
+        radius.reserve(n);
+        visible.reserve(n);
+        slowed.reserve(n);
+        path_dist.reserve(n);
+        enemy.reserve(n);
+        sorted_dist.reserve(n);
+    }
+    void Add(Enemy *e, Vector2 pos, float r, bool isVisible, bool isSlowed, int pathDist)
+    {
+        x.push_back(pos.x);
+        y.push_back(pos.y);
+        radius.push_back(r);
+        visible.push_back(isVisible);
+        slowed.push_back(isSlowed);
+        path_dist.push_back(pathDist);
+        enemy.push_back(e);
+        if (pathDist == -1)
+            off_path++;
+        else
+            sorted_dist.push_back(pathDist);
+    }
+    // after the last Add
+    void SortPathDist() { std::sort(sorted_dist.begin(), sorted_dist.end()); }
+    size_t size() const { return x.size(); }
+
+    /* is any enemy on a tile with a distance inside one of the [first, second] intervals
+     * anyone off the path (between tiles of an edited path, walking out past an exit) counts as inside all of them
+     */
+    bool AnyInIntervals(const std::vector<std::pair<int, int>> &intervals) const
+    {
+        if (off_path)
+            return true;
+        for (const auto &interval : intervals)
+        {
+            auto it = std::lower_bound(sorted_dist.begin(), sorted_dist.end(), interval.first);
+            if (it != sorted_dist.end() && *it <= interval.second)
+                return true;
+        }
+        return false;
+    }
+
+    /* closest enemy strictly inside range, -1 if none
+     * same rules the turrets always used: hidden ones only if includeHidden, slowed ones skipped if skipSlowed
+     * ties go to whoever came first, like the old loop
+     */
+    int FindClosest(Vector2 from, float range, bool includeHidden, bool skipSlowed) const
+    {
+        int best = -1;
+        float bestDistSqr = range * range;
+        const size_t n = x.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!includeHidden && !visible[i])
+                continue;
+            if (skipSlowed && slowed[i])
+                continue;
+            float dx = x[i] - from.x;
+            float dy = y[i] - from.y;
+            float distSqr = dx * dx + dy * dy;
+            if (distSqr < bestDistSqr)
+            {
+                bestDistSqr = distSqr;
+                best = (int)i;
+            }
+        }
+        return best;
+    }
+
+    // same test as CheckCollisionCircles, on the i-th enemy
+    bool Overlaps(size_t i, Vector2 center, float r) const
+    {
+        float dx = x[i] - center.x;
+        float dy = y[i] - center.y;
+        float rr = radius[i] + r;
+        return dx * dx + dy * dy <= rr * rr;
+    }
+};
@@ -1,7 +1,13 @@
 #pragma once
 #include "raylib.h"
+#include "Serialize.h"
+#include "Types.h"
+#include <cstddef>
 #include <unordered_set>
 // this above line is only here because everyone implicitly imports entity
+
+class BodyTable;
+
 class Entity
 {
   public:
@@ -9,13 +15,35 @@ class Entity
 
     virtual void Update(float deltaTime) = 0;
     virtual void Draw() = 0;
+    // how far from position this entity can draw, used for culling against the camera view
+    virtual float GetDrawRadius() { return 64.0f; }
     bool IsActive() const { return is_active; }
     virtual void Destroy() { is_active = false; }
-    Vector2 GetPosition() const { return position; }
-    Vector2 GetVelocity() const { return velocity; }
+    // turrets keep these themselves, enemies and projectiles in their row of a BodyTable (Bodies.h)
+    virtual Vector2 GetPosition() const = 0;
+    virtual Vector2 GetVelocity() const = 0;
+    virtual void SetPosition(Vector2 pos) = 0;
+    virtual void SetVelocity(Vector2 vel) = 0;
+
+    // snapshot support, each class writes its own fields after its parent's (see Snapshot.cpp)
+    virtual void Save(BinaryWriter &out)
+    {
+        out.Write(GetPosition());
+        out.Write(GetVelocity());
+        out.WriteBool(is_active);
+    }
+    virtual void Load(BinaryReader &in)
+    {
+        SetPosition(in.Read<Vector2>());
+        SetVelocity(in.Read<Vector2>());
+        if (!in.ReadBool())
+            Destroy();
+    }
 
     // protected:
-    Vector2 position;
-    Vector2 velocity;
     bool is_active = true;
+    EntityKind kind; // set by Turret, Enemy and Projectile constructors
+    // enemies and projectiles: the table their components are in and their row in it, kept up to date by BodyTable::Compact()
+    BodyTable *bodies = nullptr;
+    size_t body = 0;
 };
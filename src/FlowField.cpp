@@ -0,0 +1,269 @@
+#include "FlowField.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+static const int DR[4] = {1, 0, -1, 0};
+static const int DC[4] = {0, 1, 0, -1};
+
+void FlowField::Reset(int newRows, int newCols, float tileSize)
+{
+    rows = newRows;
+    cols = newCols;
+    tile_size = tileSize;
+    dist.assign(rows * cols, -1);
+    walkable.assign(rows * cols, 0);
+    exit.assign(rows * cols, 0);
+}
+
+void FlowField::Build()
+{
+    version++;
+    std::fill(dist.begin(), dist.end(), -1);
+    queue.clear();
+    for (int i = 0; i < rows * cols; i++)
+    {
+        if (exit[i])
+        {
+            dist[i] = 0;
+            queue.push_back(i);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        int index = queue[head];
+        int r = index / cols, c = index % cols;
+        for (int d = 0; d < 4; d++)
+        {
+            int nr = r + DR[d], nc = c + DC[d];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            int next = nr * cols + nc;
+            if (dist[next] != -1 || !walkable[next])
+                continue;
+            dist[next] = dist[index] + 1;
+            queue.push_back(next);
+        }
+    }
+    last_update_cells = (int)queue.size();
+}
+
+/* adding a tile can only make things shorter: give it its best neighbour + 1 and spread the decrease
+ * removing one can only make things longer, for the tiles that got their distance through it:
+ *   - collect everything "downstream" of it (neighbours with exactly one more step, and so on)
+ *   - going out from the removed tile in order of distance, a tile keeps its distance if some neighbour
+ *     that wasn't dropped is one step closer, otherwise it is dropped too
+ *   - the dropped ones get refilled from the tiles around them that kept theirs, smallest first
+ */
+void FlowField::SetWalkable(int index, bool isWalkable)
+{
+    version++;
+    if (index < 0 || index >= rows * cols || walkable[index] == (unsigned char)isWalkable)
+        return;
+    int r = index / cols, c = index % cols;
+    last_update_cells = 0;
+    // min-heap of (distance, tile) for spreading new distances out
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> open;
+
+    if (isWalkable)
+    {
+        walkable[index] = 1;
+        int best = -1;
+        for (int d = 0; d < 4; d++)
+        {
+            int nr = r + DR[d], nc = c + DC[d];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            int n = dist[nr * cols + nc];
+            if (n != -1 && (best == -1 || n + 1 < best))
+                best = n + 1;
+        }
+        if (exit[index])
+            best = 0;
+        if (best == -1)
+            return; // not connected to anything yet
+        dist[index] = best;
+        open.push({best, index});
+    }
+    else
+    {
+        walkable[index] = 0;
+        exit[index] = 0;
+        // everything downstream, in order of distance (BFS from the removed tile along +1 steps)
+        queue.clear();
+        queue.push_back(index);
+        std::vector<int> dropped;
+        dropped.push_back(index);
+        if ((int)isDropped.size() != rows * cols)
+            isDropped.assign(rows * cols, 0);
+        isDropped[index] = 1;
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int at = queue[head];
+            int ar = at / cols, ac = at % cols;
+            for (int d = 0; d < 4; d++)
+            {
+                int nr = ar + DR[d], nc = ac + DC[d];
+                if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                    continue;
+                int next = nr * cols + nc;
+                if (isDropped[next] || dist[next] != dist[at] + 1 || exit[next])
+                    continue;
+                // still has another neighbour one step closer that stays? then it keeps its distance
+                bool supported = false;
+                for (int e = 0; e < 4 && !supported; e++)
+                {
+                    int sr = nr + DR[e], sc = nc + DC[e];
+                    if (sr < 0 || sc < 0 || sr >= rows || sc >= cols)
+                        continue;
+                    int s = sr * cols + sc;
+                    supported = !isDropped[s] && dist[s] != -1 && dist[s] == dist[next] - 1;
+                }
+                if (supported)
+                    continue;
+                isDropped[next] = 1;
+                dropped.push_back(next);
+                queue.push_back(next);
+            }
+        }
+        for (int at : dropped)
+        {
+            dist[at] = -1;
+            isDropped[at] = 0; // only the refill below still needs to know, and it goes by dist == -1
+        }
+        // refill from whatever is left around the dropped tiles
+        for (int at : dropped)
+        {
+            if (!walkable[at])
+                continue;
+            int ar = at / cols, ac = at % cols;
+            int best = -1;
+            for (int d = 0; d < 4; d++)
+            {
+                int nr = ar + DR[d], nc = ac + DC[d];
+                if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                    continue;
+                int n = dist[nr * cols + nc];
+                if (n != -1 && (best == -1 || n + 1 < best))
+                    best = n + 1;
+            }
+            if (best != -1)
+            {
+                dist[at] = best;
+                open.push({best, at});
+            }
+        }
+        last_update_cells = (int)dropped.size();
+    }
+
+    // spread, only ever lowering distances
+    while (!open.empty())
+    {
+        auto [d0, at] = open.top();
+        open.pop();
+        if (d0 != dist[at])
+            continue; // found a shorter one since
+        last_update_cells++;
+        int ar = at / cols, ac = at % cols;
+        for (int d = 0; d < 4; d++)
+        {
+            int nr = ar + DR[d], nc = ac + DC[d];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            int next = nr * cols + nc;
+            if (!walkable[next] || (dist[next] != -1 && dist[next] <= d0 + 1))
+                continue;
+            dist[next] = d0 + 1;
+            open.push({d0 + 1, next});
+        }
+    }
+}
+
+int FlowField::IndexAt(Vector2 pos) const
+{
+    int col = (int)floorf(pos.x / tile_size);
+    int row = (int)floorf(pos.y / tile_size);
+    if (row < 0 || col < 0 || row >= rows || col >= cols)
+        return -1;
+    return row * cols + col;
+}
+
+Vector2 FlowField::Center(int index) const
+{
+    return Vector2{(index % cols) * tile_size + tile_size / 2, (index / cols) * tile_size + tile_size / 2};
+}
+
+int FlowField::DistAt(Vector2 pos) const
+{
+    int index = IndexAt(pos);
+    return index == -1 ? -1 : dist[index];
+}
+
+Vector2 FlowField::NextTarget(Vector2 pos, Vector2 heading, unsigned long long salt, bool &leaving) const
+{
+    leaving = false;
+    int index = IndexAt(pos);
+    if (index == -1)
+        return pos;
+    int r = index / cols, c = index % cols;
+
+    if (exit[index])
+    {
+        // walk off the border, or just stop here for an exit in the middle of the map
+        leaving = true;
+        Vector2 out = Center(index);
+        if (r == rows - 1)
+            out.y += tile_size;
+        else if (r == 0)
+            out.y -= tile_size;
+        else if (c == cols - 1)
+            out.x += tile_size;
+        else if (c == 0)
+            out.x -= tile_size;
+        return out;
+    }
+
+    // which way it is going now, as one of the 4 directions
+    int straight = -1;
+    if (heading.x != 0 || heading.y != 0)
+    {
+        if (fabsf(heading.x) > fabsf(heading.y))
+            straight = heading.x > 0 ? 1 : 3;
+        else
+            straight = heading.y > 0 ? 0 : 2;
+    }
+
+    int options[4];
+    int count = 0;
+    int here = dist[index];
+    int bestDist = -1;
+    for (int d = 0; d < 4; d++)
+    {
+        int nr = r + DR[d], nc = c + DC[d];
+        if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+            continue;
+        int n = dist[nr * cols + nc];
+        if (n == -1)
+            continue;
+        // normally exactly one step closer, if this tile got walled off (here == -1) any way back in will do
+        if (here != -1 && n != here - 1)
+            continue;
+        if (here == -1 && bestDist != -1 && n > bestDist)
+            continue;
+        if (here == -1 && (bestDist == -1 || n < bestDist))
+        {
+            bestDist = n;
+            count = 0;
+        }
+        options[count++] = d;
+    }
+    if (count == 0)
+        return Center(index); // nowhere to go, wait in the middle of the tile
+    int pick = options[salt % count];
+    for (int i = 0; i < count; i++)
+    {
+        if (options[i] == straight)
+            pick = straight;
+    }
+    return Center((r + DR[pick]) * cols + c + DC[pick]);
+}
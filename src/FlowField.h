@@ -0,0 +1,43 @@
+#pragma once
+#include "raylib.h"
+#include <vector>
+
+/* Distance field over the walkable tiles, steps to the nearest exit
+ * Built once when the map loads (one BFS from all exits at once), after that a tile that
+ * becomes walkable or stops being walkable only redoes the part of the field that depends on it.
+ * Enemies don't carry paths, when one reaches the middle of a tile it asks NextTarget() where to go,
+ * which is one lookup in dist for the tile and its 4 neighbours. Any number of spawns and exits work,
+ * where two ways are equally short enemies split between them by id.
+ */
+class FlowField
+{
+  public:
+    int rows = 0;
+    int cols = 0;
+    float tile_size = 0.0f;
+    std::vector<int> dist;               // steps to the nearest exit, -1 = walled off or not walkable
+    std::vector<unsigned char> walkable; // per tile, row * cols + col
+    std::vector<unsigned char> exit;
+    int last_update_cells = 0; // tiles whose distance the last Build / SetWalkable touched
+    unsigned int version = 0;  // goes up whenever dist may have changed, for anything cached from it
+
+    void Reset(int newRows, int newCols, float tileSize);
+    void SetExit(int index) { exit[index] = 1; walkable[index] = 1; }
+    // full BFS, after Reset and all the SetWalkable / SetExit calls for a new map
+    void Build();
+    // a tile changed on a live map, only what depends on it gets redone
+    void SetWalkable(int index, bool isWalkable);
+
+    int DistAt(Vector2 pos) const;
+    /* where an enemy standing (about) at pos heads next: the middle of the neighbouring tile one step closer to an exit
+     * heading keeps it going straight when that is as short, salt (the enemy id) picks between equal branches otherwise
+     * on an exit tile it gets a point just off the map if the exit is on the border, and leaving is set
+     */
+    Vector2 NextTarget(Vector2 pos, Vector2 heading, unsigned long long salt, bool &leaving) const;
+
+  private:
+    int IndexAt(Vector2 pos) const;
+    Vector2 Center(int index) const;
+    std::vector<int> queue; // reused by Build and SetWalkable
+    std::vector<unsigned char> isDropped; // all zero between calls
+};
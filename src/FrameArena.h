@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+/* Bump allocator for things that only live for one frame
+ * Hands out memory from one buffer by moving an offset forward, never frees anything on its own,
+ * and Reset() after EndDrawing() throws the whole frame away at once.
+ * It's a std::pmr::memory_resource, so any pmr container can sit on top of it (see FrameVector).
+ * If a frame needs more than the buffer, the rest comes from the heap until the next Reset(),
+ * and overflows counts it, so the buffer size can be bumped.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+  public:
+    explicit FrameArena(size_t capacity) : buffer(capacity) { overflow_blocks.reserve(64); }
+
+    void Reset()
+    {
+        last_frame_used = used;
+        if (used > peak_used)
+            peak_used = used;
+        last_frame_overflows = overflows;
+        for (auto &block : overflow_blocks)
+        {
+            ::operator delete(block.ptr, block.bytes, std::align_val_t(block.align));
+        }
+        overflow_blocks.clear();
+        used = 0;
+        overflows = 0;
+    }
+
+    size_t Capacity() const { return buffer.size(); }
+    size_t last_frame_used = 0; // bytes handed out last frame
+    size_t peak_used = 0;       // most bytes any frame has needed so far
+    int last_frame_overflows = 0;
+
+  private:
+    struct Block
+    {
+        void *ptr;
+        size_t bytes;
+        size_t align;
+    };
+    std::vector<std::byte> buffer;
+    size_t used = 0;
+    int overflows = 0;
+    std::vector<Block> overflow_blocks;
+
+    void *do_allocate(size_t bytes, size_t align) override
+    {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + bytes <= buffer.size())
+        {
+            used = start + bytes;
+            return buffer.data() + start;
+        }
+        overflows++;
+        void *ptr = ::operator new(bytes, std::align_val_t(align));
+        overflow_blocks.push_back({ptr, bytes, align});
+        return ptr;
+    }
+    // nothing to do, everything goes at once in Reset()
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+// vector whose storage is on the frame arena, only valid until the end of the frame
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
@@ -0,0 +1,565 @@
+// GameState.cpp
+// standard includes
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <vector>
+// custom includes
+#include "GameState.h"
+#include "Config.h"
+#include "Enemy.h"
+#include "Projectile.h"
+#include "Snapshot.h"
+#include "Systems.h"
+#include "Turret.h"
+#include "raylib.h"
+#include "utils.h"
+using namespace std;
+
+thread_local GameState *game = nullptr;
+
+GameState::GameState()
+{
+    // the map works out paths and the flow field into whichever game is current, this one for now
+    GameState *previous = game;
+    game = this;
+    map.BuildDefault();
+    game = previous;
+}
+
+void GameState::NewGame(unsigned int seed)
+{
+    MakeCurrent();
+    entities.clear(); // raw pointers invalid now
+    parkedCount = 0;
+    map.ClearTurrets();
+    particles.cleanup();
+    damage_events.clear();
+    enemy_table.clear();
+    player_health = 10;
+    playerMoney = 250;
+    enemy_health_multiplier = 1.0f;
+    enemies_killed = 0;
+    wave_manager.reset();
+    stat_manager.reset();
+    next_enemy_id = seed;
+    next_enemy_path = (int)(seed % 1024);
+    next_projectile_id = 0;
+    rewind_buffer.Clear();
+    simTick = 0;
+    forceSnapshot = true;
+    lodClock = 0.0;
+    Record(TelemetryKind::NEW_GAME, seed);
+}
+
+bool GameState::LoadMap(const char *path)
+{
+    MakeCurrent();
+    if (map.LoadFromFile(path))
+        return true;
+    map.BuildDefault();
+    return false;
+}
+
+bool GameState::BuildTurret(TurretType type, Tile *tile)
+{
+    MakeCurrent();
+    int cost = Turret::Cost(type);
+    if (tile->GetType() != TileType::BUILDABLE || tile->HasTurret() || playerMoney < cost)
+        return false;
+    auto turret = Turret::Make(type, map.TileCenter(tile), tile);
+    turret->stats_slot = stat_manager.TurretBuilt(type, cost);
+    map.PlaceTurret(tile, turret.get());
+    entities.push_back(std::move(turret));
+    playerMoney -= cost;
+    Record(TelemetryKind::BUILD, map.IndexOf(tile), (float)cost, 0, (int)type);
+    return true;
+}
+
+// sorts a list of [from, to] distance intervals and merges the ones that overlap or touch
+static void MergeIntervals(vector<pair<int, int>> &intervals)
+{
+    sort(intervals.begin(), intervals.end());
+    size_t merged = 0;
+    for (size_t i = 0; i < intervals.size(); i++)
+    {
+        if (merged > 0 && intervals[i].first <= intervals[merged - 1].second + 1)
+            intervals[merged - 1].second = max(intervals[merged - 1].second, intervals[i].second);
+        else
+            intervals[merged++] = intervals[i];
+    }
+    intervals.resize(merged);
+}
+
+// steps from d to the nearest distance in intervals (sorted, merged), 0 inside one, INT_MAX if there are none
+static int IntervalGap(const vector<pair<int, int>> &intervals, int d)
+{
+    auto next = lower_bound(intervals.begin(), intervals.end(), pair<int, int>{d, INT_MIN});
+    int gap = INT_MAX;
+    if (next != intervals.end())
+        gap = next->first - d;
+    if (next != intervals.begin())
+    {
+        auto previous = next - 1;
+        gap = min(gap, previous->second >= d ? 0 : d - previous->second);
+    }
+    return gap;
+}
+
+/* sim LOD: an enemy nowhere near anything that could touch it is "parked", left out of the tick
+ * (no enemy table, no targeting, no collision checks against it) and caught up later by running the ticks it missed
+ * with their dts, Update(dt) then Update() like the full tick, so it comes out exactly where it would have been.
+ * On its own an enemy can't do anything that needs the others: polys never park, and on a tick one heals everyone is caught up first.
+ *
+ * "nowhere near" is the flow field distance trick fast-forward uses, but with every turret's reach instead of its range
+ * (bullets keep flying well past what they were aimed at) and the exits on top, leaking needs the player's health.
+ * A parked enemy is caught up when its distance at full speed could run out, after sim_lod_max_ticks,
+ * when a turret or the path changes, when it could be on screen, and before anything saves the game.
+ */
+
+// true when it had to be worked out again, anything parked by the old one can't be trusted
+bool GameState::UpdateReachDists()
+{
+    if (reachFlowVersion == flow_field.version && reachTurretsVersion == map.turrets_version)
+        return false;
+    reachFlowVersion = flow_field.version;
+    reachTurretsVersion = map.turrets_version;
+    reachDists.clear();
+    vector<pair<int, int>> intervals;
+    for (auto &entity : entities)
+    {
+        if (entity->kind != EntityKind::TURRET || !entity->IsActive())
+            continue;
+        Turret *turret = static_cast<Turret *>(entity.get());
+        Turret::PathIntervalsWithin(turret->position, turret->InteractionReach(), intervals);
+        reachDists.insert(reachDists.end(), intervals.begin(), intervals.end());
+    }
+    reachDists.push_back({0, 0});
+    MergeIntervals(reachDists);
+    int maxDist = flow_field.dist.empty() ? 0 : *max_element(flow_field.dist.begin(), flow_field.dist.end());
+    reachGap.resize(maxDist + 1);
+    for (int d = 0; d <= maxDist; d++)
+    {
+        reachGap[d] = IntervalGap(reachDists, d);
+    }
+    return true;
+}
+
+void GameState::CatchUp(Enemy *enemy)
+{
+    for (unsigned long long t = enemy->parked_since; t < simTick; t++)
+    {
+        float dt = lodDts[t % LOD_RING];
+        MoveEnemy(enemy_bodies, enemy->body, map_bounds, dt);
+        enemy->Update(dt);
+        enemy->Update();
+    }
+    enemy->SetParked(false);
+}
+
+void GameState::CatchUpAll()
+{
+    MakeCurrent();
+    if (parkedCount == 0)
+        return;
+    for (auto &entity : entities)
+    {
+        if (entity->IsActive() && entity->kind == EntityKind::ENEMY && static_cast<Enemy *>(entity.get())->IsParked())
+            CatchUp(static_cast<Enemy *>(entity.get()));
+    }
+    parkedCount = 0;
+}
+
+// parks enemy from this tick on if it can't get within reach of anything before the tick is over
+bool GameState::TryPark(Enemy *enemy, float dt)
+{
+    Vector2 pos = enemy->GetPosition();
+    if (!CheckCollisionPointRec(pos, map_bounds))
+        return false;
+    int d = flow_field.DistAt(pos);
+    if (d < 1 || d >= (int)reachGap.size())
+        return false;
+    int gap = reachGap[d];
+    float speed = max(enemy->speed, enemy->original_speed);
+    if (gap < 2 || speed <= 0.0f)
+        return false;
+    // the same one tile per tile crossed as fast-forward, the time it takes at the most it can be walking
+    double until = lodClock + ((gap - 1) * TILE_SIZE - 1.0f) / speed;
+    if (lodClock + dt > until)
+        return false;
+    enemy->SetParked(true);
+    enemy->parked_since = simTick;
+    enemy->parked_at = lodClock;
+    enemy->parked_until = until;
+    return true;
+}
+
+// start of every full tick, wakes whoever has to be and parks whoever can be
+void GameState::UpdateParking(float dt)
+{
+    bool reachChanged = UpdateReachDists();
+    bool canPark = sim_lod && dt <= sim_lod_max_dt && !reachChanged;
+    if (!canPark && parkedCount == 0)
+        return;
+    bool actionDue = false;
+    parkedCount = 0;
+    for (auto &entity : entities)
+    {
+        if (!entity->IsActive() || entity->kind != EntityKind::ENEMY)
+            continue;
+        Enemy *enemy = static_cast<Enemy *>(entity.get());
+        if (enemy->HasEnemyAction())
+        {
+            // a poly healing this tick looks at everyone around it
+            if (enemy->TicksUntilAction(dt, 1) == 0)
+                actionDue = true;
+            continue;
+        }
+        if (enemy->IsParked())
+        {
+            if (canPark && lodClock + dt <= enemy->parked_until && simTick - enemy->parked_since < (unsigned long long)sim_lod_max_ticks)
+            {
+                parkedCount++;
+                continue;
+            }
+            CatchUp(enemy);
+        }
+        if (canPark && TryPark(enemy, dt))
+            parkedCount++;
+    }
+    if (actionDue)
+        CatchUpAll();
+}
+
+// before drawing, anything parked that could have walked into view since
+void GameState::CatchUpInView(const Rectangle &view)
+{
+    MakeCurrent();
+    if (parkedCount == 0)
+        return;
+    for (auto &entity : entities)
+    {
+        if (!entity->IsActive() || entity->kind != EntityKind::ENEMY)
+            continue;
+        Enemy *enemy = static_cast<Enemy *>(entity.get());
+        if (!enemy->IsParked())
+            continue;
+        float walked = max(enemy->speed, enemy->original_speed) * (float)(lodClock - enemy->parked_at);
+        if (IsInView(view, enemy->GetPosition(), enemy->GetDrawRadius() + walked))
+        {
+            CatchUp(enemy);
+            parkedCount--;
+        }
+    }
+}
+
+static bool IsParked(const unique_ptr<Entity> &entity)
+{
+    return entity->kind == EntityKind::ENEMY && static_cast<Enemy *>(entity.get())->IsParked();
+}
+
+/* One step of the simulation, everything that changes the game state lives in here
+ * dt is passed in instead of reading GetFrameTime(), so the rewind buffer can replay logged ticks with the same dts
+ */
+void GameState::SimulateTick(float dt)
+{
+    lodDts[simTick % LOD_RING] = dt;
+    UpdateParking(dt);
+    // movement on the component tables, then simple Update for all entities for whatever is still in the classes
+    // parked enemies get both when they're caught up
+    MoveEnemies(enemy_bodies, map_bounds, dt);
+    MoveProjectiles(projectile_bodies, dt);
+    for (auto &entity : entities)
+    {
+        if (!IsParked(entity))
+            entity->Update(dt);
+    }
+    particles.Update(dt);
+    stat_manager.Tick(dt);
+
+    // Separate entities into turrets and enemies, the projectiles are only needed as their rows in projectile_bodies
+    // these only live for this frame, so they sit on the frame arena instead of the heap
+    FrameVector<Turret *> turret_ptrs(&frame_arena);
+    FrameVector<Enemy *> enemy_ptrs(&frame_arena);
+    FrameVector<unique_ptr<Entity>> newProjectiles(&frame_arena);
+    turret_ptrs.reserve(entities.size());
+    enemy_ptrs.reserve(entities.size());
+
+    for (auto &entity : entities)
+    {
+        if (!entity->IsActive())
+            continue;
+        // kind is set once in the constructor, cheaper than trying dynamic_cast three times
+        switch (entity->kind)
+        {
+        case EntityKind::TURRET:
+            turret_ptrs.push_back(static_cast<Turret *>(entity.get()));
+            break;
+        case EntityKind::ENEMY:
+            if (!static_cast<Enemy *>(entity.get())->IsParked())
+                enemy_ptrs.push_back(static_cast<Enemy *>(entity.get()));
+            break;
+        case EntityKind::PROJECTILE:
+            break;
+        }
+    }
+    // the same enemies and projectiles are the ones the collision pass below looks at, whatever spawns or dies in between
+    enemy_bodies.MarkInPlay();
+    projectile_bodies.MarkInPlay();
+    // flat arrays of enemy positions for targeting below
+    enemy_table.clear();
+    enemy_table.reserve(enemy_ptrs.size());
+    for (auto *enemy : enemy_ptrs)
+    {
+        Vector2 pos = enemy->GetPosition();
+        enemy_table.Add(enemy, pos, enemy->GetRadius(), enemy->isVisible, enemy->status_effect == StatusEffects::SLOWED, flow_field.DistAt(pos));
+    }
+    enemy_table.SortPathDist();
+
+    // Update turrets with knowledge of enemies
+    // a turret with no enemy anywhere on its stretches of path would only find nothing, so it sleeps instead
+    // hidden crawlers are counted like everyone else, the wave turret zone and salvo have to see them
+    turretsAwake = 0;
+    turretCount = (int)turret_ptrs.size();
+    for (auto &turret : turret_ptrs)
+    {
+        if (turret_sleep && !turret->EnemiesInReach())
+            continue;
+        turret->Update(dt, enemy_ptrs, newProjectiles);
+        turretsAwake++;
+    }
+
+    // Update enemy
+    for (auto &enemy : enemy_ptrs)
+    {
+        enemy->DoEnemyAction(enemy_ptrs, dt);
+        enemy->Update();
+    }
+    // update wave information, parked enemies are still alive
+    wave_manager.Update(dt, entities, enemy_ptrs.size() + parkedCount);
+
+    // ---- INTERACTION PASS -----
+    // Projectiles interact with enemies, straight on the component tables (Systems.cpp)
+    CollideProjectiles(projectile_bodies, enemy_bodies);
+
+    // ---- DAMAGE RESOLUTION ----
+    // every hit from beams and projectiles this tick gets applied here, in one go
+    damage_events.Resolve();
+
+    // --- CLEANUP AND ADDITION PASS ---
+    for (auto &p : newProjectiles)
+    {
+        entities.push_back(std::move(p));
+    }
+
+    entities.erase(remove_if(entities.begin(), entities.end(), [](const auto &entity) { return !entity->IsActive(); }), entities.end());
+    lodClock += dt;
+}
+
+void GameState::TakeRewindSnapshot()
+{
+    CatchUpAll();
+    rewindWriter.clear();
+    SaveSnapshot(rewindWriter, *this);
+    rewind_buffer.Push(simTick, rewindWriter.data);
+    forceSnapshot = false;
+}
+
+// every tick of the game goes through here
+void GameState::StepSimulation(float dt)
+{
+    MakeCurrent();
+    // state before this tick goes in the rewind buffer every few ticks, and right after the player changed something
+    if (record_rewind && (forceSnapshot || rewind_buffer.IsDue(simTick)))
+    {
+        TakeRewindSnapshot();
+    }
+    SimulateTick(dt);
+    if (record_rewind)
+        rewind_buffer.LogTick(simTick, dt);
+    simTick++;
+}
+
+/* fast-forward: while no enemy can get near a turret nothing in the game touches anything else,
+ * enemies walk, timers count down and the wave spawns on schedule, all of it by itself.
+ * Those ticks skip the turret, collision and damage passes and the enemy table.
+ * They still go one at a time with the same dt, so every float comes out exactly as in a full tick,
+ * it's only the work in between that goes.
+ *
+ * How far ahead is safe comes from the flow field distances (the same ones turrets sleep by):
+ * every path tile a turret reaches is "covered", an enemy on a tile d steps from the exit
+ * can't get to a covered one before it has crossed as many tiles as the nearest covered distance is away.
+ * The window ends before any enemy could, before a poly's heal comes off cooldown, before the next
+ * rewind snapshot, and right after anything spawns, leaks or the wave changes state.
+ */
+void GameState::UpdateCoveredDists()
+{
+    if (coveredFlowVersion == flow_field.version && coveredTurretsVersion == map.turrets_version)
+        return;
+    coveredFlowVersion = flow_field.version;
+    coveredTurretsVersion = map.turrets_version;
+    coveredDists.clear();
+    coveredOffMap = false;
+    for (auto &entity : entities)
+    {
+        if (entity->kind != EntityKind::TURRET || !entity->IsActive())
+            continue;
+        Turret *turret = static_cast<Turret *>(entity.get());
+        if (turret->path_intervals_version != flow_field.version)
+            turret->BuildPathIntervals();
+        coveredDists.insert(coveredDists.end(), turret->path_intervals.begin(), turret->path_intervals.end());
+        Vector2 pos = turret->position;
+        if (pos.x - turret->range < map_bounds.x || pos.y - turret->range < map_bounds.y || pos.x + turret->range > map_bounds.x + map_bounds.width ||
+            pos.y + turret->range > map_bounds.y + map_bounds.height)
+            coveredOffMap = true;
+    }
+    MergeIntervals(coveredDists);
+    // walking off the map past an exit (distance 0) is one more step, -1
+    if (coveredOffMap)
+        coveredDists.insert(coveredDists.begin(), {-1, -1});
+}
+
+// how many ticks of dt from now (up to limit) nothing can interact, 0 if it could this tick
+int GameState::QuietTicks(float dt, int limit)
+{
+    UpdateCoveredDists();
+    // parked enemies that the next full tick would wake need that full tick
+    if (parkedCount > 0 && (!sim_lod || dt > sim_lod_max_dt || reachFlowVersion != flow_field.version || reachTurretsVersion != map.turrets_version))
+        return 0;
+    // never across the next rewind snapshot, the first tick can take it like any other
+    unsigned long long untilDue = rewind_buffer.NextDue(simTick) - simTick;
+    if (record_rewind && untilDue < (unsigned long long)limit)
+        limit = (int)untilDue;
+    for (auto &entity : entities)
+    {
+        if (!entity->IsActive() || entity->kind == EntityKind::TURRET)
+            continue;
+        if (entity->kind == EntityKind::PROJECTILE)
+            return 0; // already on its way to something
+        Enemy *enemy = static_cast<Enemy *>(entity.get());
+        if (enemy->IsParked())
+        {
+            // where it is is out of date, it's far enough for as long as it stays parked
+            limit = min(limit, (int)(enemy->parked_since + sim_lod_max_ticks - simTick));
+            if (dt > 0.0f)
+                limit = min(limit, (int)((enemy->parked_until - lodClock) / dt));
+            if (limit <= 0)
+                return 0;
+            continue;
+        }
+        limit = min(limit, enemy->TicksUntilAction(dt, limit));
+        Vector2 pos = enemy->GetPosition();
+        int d = flow_field.DistAt(pos);
+        if (d == -1)
+        {
+            // walking out past an exit is fine if no turret reaches out there, anywhere else off the path isn't
+            if (CheckCollisionPointRec(pos, map_bounds) || coveredOffMap)
+                return 0;
+            continue;
+        }
+        // steps to the nearest covered distance, INT_MAX if nothing is covered
+        int gap = IntervalGap(coveredDists, d);
+        if (gap == INT_MAX)
+            continue;
+        // one covered tile closer per tile crossed at most, a slow running out only brings back original_speed
+        float step = max(enemy->speed, enemy->original_speed) * dt;
+        if (step <= 0.0f)
+            continue;
+        int ticks = (int)(((gap - 1) * TILE_SIZE - 1.0f) / step);
+        limit = min(limit, ticks);
+        if (limit <= 0)
+            return 0;
+    }
+    return limit;
+}
+
+// SimulateTick minus everything that can't do anything while QuietTicks says it's quiet
+void GameState::QuietTick(float dt)
+{
+    lodDts[simTick % LOD_RING] = dt;
+    MoveEnemies(enemy_bodies, map_bounds, dt);
+    MoveProjectiles(projectile_bodies, dt);
+    for (auto &entity : entities)
+    {
+        // the full tick erases the dead at the end of every tick, here they wait until the window is over
+        if (entity->IsActive() && !IsParked(entity))
+            entity->Update(dt);
+    }
+    particles.Update(dt);
+    stat_manager.Tick(dt);
+    FrameVector<Enemy *> enemy_ptrs(&frame_arena);
+    enemy_ptrs.reserve(entities.size());
+    for (auto &entity : entities)
+    {
+        if (entity->IsActive() && entity->kind == EntityKind::ENEMY && !IsParked(entity))
+            enemy_ptrs.push_back(static_cast<Enemy *>(entity.get()));
+    }
+    for (auto &enemy : enemy_ptrs)
+    {
+        enemy->DoEnemyAction(enemy_ptrs, dt);
+        enemy->Update();
+    }
+    wave_manager.Update(dt, entities, enemy_ptrs.size() + parkedCount);
+    lodClock += dt;
+}
+
+int GameState::AdvanceSimulation(float dt, int maxTicks)
+{
+    MakeCurrent();
+    int quiet = fast_forward ? QuietTicks(dt, maxTicks) : 0;
+    if (quiet < 2)
+    {
+        StepSimulation(dt);
+        return 1;
+    }
+    if (record_rewind && (forceSnapshot || rewind_buffer.IsDue(simTick)))
+    {
+        TakeRewindSnapshot();
+    }
+    size_t entityCount = entities.size();
+    int health = player_health;
+    bool waveActive = wave_manager.IsWaveActive();
+    int ticks = 0;
+    while (ticks < quiet)
+    {
+        if (ticks > 0)
+            frame_arena.Reset();
+        QuietTick(dt);
+        if (record_rewind)
+            rewind_buffer.LogTick(simTick, dt);
+        simTick++;
+        ticks++;
+        // a spawn, a leak or the wave moving on, the next tick has to be looked at again
+        if (entities.size() != entityCount || player_health != health || wave_manager.IsWaveActive() != waveActive || wave_manager.IsFinished())
+            break;
+    }
+    entities.erase(remove_if(entities.begin(), entities.end(), [](const auto &entity) { return !entity->IsActive(); }), entities.end());
+    fastForwardTicks += ticks;
+    return ticks;
+}
+
+bool GameState::RewindTo(unsigned long long tick)
+{
+    MakeCurrent();
+    unsigned long long snapshotTick = 0;
+    if (!rewind_buffer.Restore(tick, rewindBytes, snapshotTick))
+        return false;
+    BinaryReader in(rewindBytes);
+    if (!LoadSnapshot(in, *this))
+        return false;
+    // the replayed ticks are logged already, the first time they ran
+    TelemetryLog *log = telemetry;
+    telemetry = nullptr;
+    for (unsigned long long t = snapshotTick; t < tick; t++)
+    {
+        simTick = t; // the sim LOD goes by it
+        SimulateTick(rewind_buffer.GetDt(t));
+        frame_arena.Reset();
+    }
+    simTick = tick;
+    telemetry = log;
+    Record(TelemetryKind::REWIND, 0);
+    rewind_buffer.DropAfter(tick);
+    forceSnapshot = true;
+    return true;
+}
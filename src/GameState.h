@@ -0,0 +1,146 @@
+#pragma once
+#include "Bodies.h"
+#include "Config.h"
+#include "Entity.h"
+#include "Map.h"
+#include "Rewind.h"
+#include "Serialize.h"
+#include "Telemetry.h"
+#include "Wave.h"
+#include "raylib.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Enemy;
+class GameState;
+
+// the game this thread is working on, see GameState
+extern thread_local GameState *game;
+
+/* One whole game: the player, the map and what's worked out from it, every entity, the waves,
+ * the per-tick systems and the simulation that runs them.
+ * Nothing in here is shared with another GameState, so any number of them can run at once,
+ * one per thread, or several on one thread taking turns.
+ *
+ * Entities and systems don't get it handed to them, they go through `game`, the one this thread is on.
+ * Every entry point below (and SaveSnapshot / LoadSnapshot) makes itself current first,
+ * anything else that touches entities from outside, like the game scene building turrets, calls MakeCurrent() before.
+ * What stays global is shared and read-only while games run: the constants in Config, the toggles
+ * (turret_sleep, fast_forward, sim_lod), the textures, and per-thread scratch (frame_arena).
+ */
+class GameState
+{
+  public:
+    // player
+    int player_health = 10;               // max enemies that can cross u
+    int playerMoney = 250;                // money u start with
+    float enemy_health_multiplier = 1.0f; // makes enemies beefier each stage
+    int enemies_killed = 0;
+    StatsManager stat_manager;
+
+    // the map, and what Map works out from it when it loads or changes
+    Map map;
+    std::vector<EnemyPath> enemy_paths;
+    std::vector<Vector2> spawn_points; // middle of every spawn tile, for the flow field
+    FlowField flow_field;
+    CoverageMap coverage_map; // turret dps / slows per tile and path segment, kept up to date by Map::PlaceTurret / RemoveTurret
+    NavMode nav_mode = NavMode::FLOW_FIELD;
+    Rectangle map_bounds = {0, 0, 0, 0}; // whole map in world coordinates, enemies outside of it get removed
+
+    // everything in the world, and what works on it every tick
+    // components of the enemies and projectiles (Bodies.h), before entities so they're still there while those get destroyed
+    BodyTable enemy_bodies;
+    BodyTable projectile_bodies;
+    std::vector<std::unique_ptr<Entity>> entities;
+    WaveManager wave_manager;
+    ParticleSystem particles;
+    DamageQueue damage_events; // hits recorded this tick, resolved once per tick
+    EnemyTable enemy_table;    // flat copy of live enemies for turret targeting, rebuilt every tick
+    // id counters, saved with the snapshot so ids keep going where they left off
+    unsigned long long next_enemy_id = 0;
+    int next_enemy_path = 0;
+    unsigned long long next_projectile_id = 0;
+
+    Camera2D camera = {0};
+
+    // rewind, simTick counts simulated ticks since the game started
+    RewindBuffer rewind_buffer{rewind_budget_bytes, rewind_snapshot_interval, rewind_keyframe_every};
+    unsigned long long simTick = 0;
+    bool forceSnapshot = true; // player changed something, snapshot before the next tick
+    bool record_rewind = true; // off for headless games, nobody rewinds those
+
+    // gameplay events go here while it's set (not owned, see Telemetry.h)
+    TelemetryLog *telemetry = nullptr;
+    void Record(TelemetryKind kind, unsigned long long id, float value = 0.0f, int enemy = 0, int turret = TURRET_TYPE_COUNT)
+    {
+        if (telemetry)
+            telemetry->Push({simTick, (unsigned int)id, value, kind, (unsigned char)enemy, (unsigned char)turret});
+    }
+
+    // last tick / frame, for the HUD
+    int turretsAwake = 0;
+    int turretCount = 0;
+    int fastForwardTicks = 0; // reset by whoever counts them
+    int parkedCount = 0;      // sim LOD, counted every full tick
+
+    // starts out on the built-in map
+    GameState();
+    GameState(const GameState &) = delete;
+    GameState &operator=(const GameState &) = delete;
+
+    void MakeCurrent() { game = this; }
+    /* a fresh game on whatever map is loaded, turrets and all gone
+     * seed is where the enemy ids and the spawn rotation start, the only things that decide between
+     * equally good choices (which spawn, which of two equally short branches), the rest of the sim has no randomness
+     */
+    void NewGame(unsigned int seed = 0);
+    // path, or the built-in map if it won't load (returns false then)
+    bool LoadMap(const char *path);
+
+    // a turret on the middle of tile, paid for, false without the money or on a tile that can't take one
+    bool BuildTurret(TurretType type, Tile *tile);
+
+    // one tick, or a whole quiet window of them (never more than maxTicks), returns how many ran
+    int AdvanceSimulation(float dt, int maxTicks);
+    // one full tick with the rewind bookkeeping around it
+    void StepSimulation(float dt);
+    /* back to tick, load the closest snapshot at or before it and play the logged ticks after it again
+     * the future after tick is dropped, the game goes on from there as a new timeline
+     */
+    bool RewindTo(unsigned long long tick);
+    void TakeRewindSnapshot();
+    // sim LOD: every parked enemy caught up, before anything reads or changes what they walk on
+    void CatchUpAll();
+    // and only the ones that could be inside view (world coordinates), before drawing
+    void CatchUpInView(const Rectangle &view);
+
+  private:
+    std::vector<unsigned char> rewindBytes; // reused, so a rewind doesn't grow a new buffer every time
+    BinaryWriter rewindWriter;              // same for snapshots
+
+    void SimulateTick(float dt);
+
+    // fast-forward, see GameState.cpp
+    std::vector<std::pair<int, int>> coveredDists; // every turret's path_intervals merged, sorted
+    bool coveredOffMap = false;                    // some turret reaches past the map edge, where enemies walk out
+    unsigned int coveredFlowVersion = 0;
+    unsigned int coveredTurretsVersion = ~0u;
+    void UpdateCoveredDists();
+    int QuietTicks(float dt, int limit);
+    void QuietTick(float dt);
+
+    // sim LOD, see GameState.cpp
+    static const int LOD_RING = 64; // dts of the last ticks, sim_lod_max_ticks has to fit in here
+    float lodDts[LOD_RING] = {};
+    double lodClock = 0.0;                         // game seconds simulated, what parked_at / parked_until are on
+    std::vector<std::pair<int, int>> reachDists;   // every turret's InteractionReach as flow field distances, exits included
+    std::vector<int> reachGap;                     // gap to reachDists for every d on the field, asked for every enemy every tick
+    unsigned int reachFlowVersion = 0;
+    unsigned int reachTurretsVersion = ~0u;
+    bool UpdateReachDists();
+    void CatchUp(Enemy *enemy);
+    bool TryPark(Enemy *enemy, float dt);
+    void UpdateParking(float dt);
+};
+
@@ -0,0 +1,78 @@
+#pragma once
+#include "raylib.h"
+#include "rlgl.h"
+#include <vector>
+
+/* Health bars for every enemy, drawn in one go
+ * Enemies only Push() while they draw their sprites, Flush() runs once after all sprites
+ * and writes every bar as quads into a single rlgl batch.
+ * Interleaving them with the sprites (and their blend mode switches) used to break the batch per enemy.
+ * Full health enemies get no bar at all, unless always_show is on (Settings)
+ */
+struct HealthBar
+{
+    Vector2 pos;    // entity position, bar sits above it
+    float fraction; // curr / max, 0..1
+};
+
+class HealthBarBatch
+{
+  public:
+    std::vector<HealthBar> bars;
+    bool always_show = false;
+
+    // helper to put a health bar on top of any entity,
+    // kept here to make this functionality reusable
+    void Push(float curr_health, float max_health, Vector2 entity_pos)
+    {
+        if (curr_health >= max_health && !always_show)
+            return;
+        float fraction = curr_health / max_health;
+        fraction = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction); // healers can push hp over max
+        bars.push_back({entity_pos, fraction});
+    }
+
+    void Flush()
+    {
+        if (bars.empty())
+            return;
+        // the shapes texture is what raylib itself uses for plain rectangles,
+        // so this batch can merge with whatever shape drawing comes next
+        Texture2D shapes = GetShapesTexture();
+        Rectangle src = GetShapesTextureRectangle();
+        float u0 = src.x / shapes.width, v0 = src.y / shapes.height;
+        float u1 = (src.x + src.width) / shapes.width, v1 = (src.y + src.height) / shapes.height;
+
+        rlSetTexture(shapes.id);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for (const auto &bar : bars)
+        {
+            float x = bar.pos.x - bar_width / 2;
+            float y = bar.pos.y - bar_thickness * 4;
+            Quad(x, y, bar_width, GRAY, u0, v0, u1, v1);
+            Quad(x, y, bar_width * bar.fraction, RED, u0, v0, u1, v1);
+        }
+        rlEnd();
+        rlSetTexture(0);
+        bars.clear();
+    }
+
+  private:
+    const float bar_thickness = 5.0f;
+    const float bar_width = 20.0f;
+
+    // same vertex order as raylib's own DrawRectanglePro
+    void Quad(float x, float y, float width, Color color, float u0, float v0, float u1, float v1)
+    {
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlTexCoord2f(u0, v0);
+        rlVertex2f(x, y);
+        rlTexCoord2f(u0, v1);
+        rlVertex2f(x, y + bar_thickness);
+        rlTexCoord2f(u1, v1);
+        rlVertex2f(x + width, y + bar_thickness);
+        rlTexCoord2f(u1, v0);
+        rlVertex2f(x + width, y);
+    }
+};
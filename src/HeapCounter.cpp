@@ -0,0 +1,72 @@
+#include "HeapCounter.h"
+#include <cstdlib>
+#include <new>
+
+std::atomic<unsigned long long> heap_allocation_count{0};
+
+// only in instrumented builds (make COUNT_HEAP=-DOZ_COUNT_HEAP), everything else keeps the stock allocator
+#ifdef OZ_COUNT_HEAP
+// replacements for the global allocation functions, same behaviour as the defaults plus a counter
+static void *CountedAlloc(std::size_t size)
+{
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    void *ptr = std::malloc(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+static void *CountedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    std::size_t a = static_cast<std::size_t>(align);
+    if (a < sizeof(void *))
+        a = sizeof(void *);
+    size = (size + a - 1) / a * a; // aligned_alloc wants a multiple of the alignment
+    if (size == 0)
+        size = a;
+    void *ptr = std::aligned_alloc(a, size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new(std::size_t size) { return CountedAlloc(size); }
+void *operator new[](std::size_t size) { return CountedAlloc(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return CountedAlloc(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return CountedAlloc(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new(std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void *operator new[](std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+#endif
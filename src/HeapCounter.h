@@ -0,0 +1,27 @@
+#pragma once
+#include <atomic>
+
+/* counts every call to the global operator new (HeapCounter.cpp replaces it)
+ * used to check that steady-state frames don't touch the heap.
+ * Only C++ allocations, raylib's own mallocs aren't seen here.
+ * Off unless built with -DOZ_COUNT_HEAP (make clean && make COUNT_HEAP=-DOZ_COUNT_HEAP),
+ * the counter then just stays at 0.
+ */
+extern std::atomic<unsigned long long> heap_allocation_count;
+#ifdef OZ_COUNT_HEAP
+const bool HEAP_COUNTING = true;
+#else
+const bool HEAP_COUNTING = false;
+#endif
+
+struct HeapFrameStats
+{
+    unsigned long long frame_start = 0;
+    unsigned long long last_frame = 0; // allocations during the last finished frame
+    void EndFrame()
+    {
+        unsigned long long now = heap_allocation_count.load(std::memory_order_relaxed);
+        last_frame = now - frame_start;
+        frame_start = now;
+    }
+};
@@ -1,21 +1,46 @@
 #include "Map.h"
 #include "Config.h"
+#include "GameState.h"
+#include "Turret.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
 #include <raylib.h>
 
 Map::Map()
 {
-    grid.clear();
-    targets.clear();
-    grid.resize(GRID_ROWS);
-    // create and allocate memory
-    for (int row = 0; row < GRID_ROWS; row++)
-    {
-        grid[row].resize(GRID_COLS);
-        for (int col = 0; col < GRID_COLS; col++)
-        {
-            grid[row][col].rect = {(float)(col * TILE_SIZE), (float)(row * TILE_SIZE), (float)TILE_SIZE, (float)TILE_SIZE};
-        }
-    }
+}
+
+void Map::Resize(int newRows, int newCols)
+{
+    rows = newRows;
+    cols = newCols;
+    // one flat allocation, a 256 x 256 map is 256 KB
+    tiles.assign(rows * cols, Tile{});
+    turret_slots.clear();
+    free_turret_slots.clear();
+    turrets_version++;
+    ResizeDerived();
+}
+
+// everything sized after the tiles: chunk cache, coverage, bounds
+void Map::ResizeDerived()
+{
+    // cached chunks belong to the old size
+    UnloadCache();
+    chunk_rows = (rows + CHUNK_TILES - 1) / CHUNK_TILES;
+    chunk_cols = (cols + CHUNK_TILES - 1) / CHUNK_TILES;
+    chunk_dirty.assign(chunk_rows * chunk_cols, 1);
+    chunk_slot.assign(chunk_rows * chunk_cols, -1);
+    game->coverage_map.Reset(rows, cols, TILE_SIZE);
+    game->map_bounds = {0, 0, cols * TILE_SIZE, rows * TILE_SIZE};
+}
+
+void Map::BuildDefault()
+{
+    name = "built-in";
+    Resize(GRID_ROWS, GRID_COLS);
     int pathCol = 1;
     bool goingDown = true;
     int segmentSpacing = 3;
@@ -30,16 +55,14 @@ Map::Map()
             // going down
             for (row = 1; row < GRID_ROWS - 1; row++)
             {
-                grid[row][pathCol].type = TileType::PATH;
+                at(row, pathCol).SetType(TileType::PATH);
             }
-            row--;
-            targets.push_back({grid[row][pathCol].rect.x + (float)TILE_SIZE / 2, grid[row][pathCol].rect.y + (float)TILE_SIZE / 2});
             // going right
             if (pathCol + segmentSpacing < GRID_COLS)
             {
                 for (col = 0; col < segmentSpacing; col++)
                 {
-                    grid[GRID_ROWS - 2][pathCol + col].type = TileType::PATH;
+                    at(GRID_ROWS - 2, pathCol + col).SetType(TileType::PATH);
                 }
             }
             else
@@ -52,10 +75,8 @@ Map::Map()
             // going up
             for (row = GRID_ROWS - 2; row >= 1; row--)
             {
-                grid[row][pathCol].type = TileType::PATH;
+                at(row, pathCol).SetType(TileType::PATH);
             }
-            row++;
-            targets.push_back({grid[row][pathCol].rect.x + (float)TILE_SIZE / 2, grid[row][pathCol].rect.y + (float)TILE_SIZE / 2});
 
             // going right
             if (pathCol + segmentSpacing < GRID_COLS)
@@ -63,7 +84,7 @@ Map::Map()
 
                 for (col = 0; col < segmentSpacing; col++)
                 {
-                    grid[1][pathCol + col].type = TileType::PATH;
+                    at(1, pathCol + col).SetType(TileType::PATH);
                 }
             }
             else
@@ -73,58 +94,570 @@ Map::Map()
         }
 
         pathCol += segmentSpacing;
-
-        // add the right segment motion after either down or up loop is finished
-        targets.push_back({grid[row][pathCol].rect.x + (float)TILE_SIZE / 2, grid[row][pathCol + col].rect.y + (float)TILE_SIZE / 2});
-
         goingDown = !goingDown;
     }
 
     // entry-exit tile
-    grid[0][1].type = TileType::PATH;
-    grid[GRID_ROWS - 1][GRID_COLS - 2].type = TileType::PATH;
-    startPos = Vector2{grid[0][1].rect.x + (float)TILE_SIZE / 2, grid[0][1].rect.y + (float)TILE_SIZE / 2};
-    // add final exit target to the targets vector
-    targets.push_back({grid[GRID_ROWS - 1][GRID_COLS - 2].rect.x + (float)TILE_SIZE / 2, grid[GRID_ROWS - 1][GRID_COLS - 2].rect.y + (float)TILE_SIZE / 2});
+    at(0, 1).SetType(TileType::PATH);
+    at(GRID_ROWS - 1, GRID_COLS - 2).SetType(TileType::PATH);
+    // waypoints come out of the same BFS as for map files
+    spawns = {0 * cols + 1};
+    exits = {(GRID_ROWS - 1) * cols + GRID_COLS - 2};
+    BuildNavigation();
 }
 
-void Map::Draw()
+bool Map::LoadFromFile(const char *path)
 {
-    for (int r = 0; r < GRID_ROWS; r++)
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    std::string fileName = path;
+    int fileCols = 0, fileRows = 0;
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line))
     {
-        for (int c = 0; c < GRID_COLS; c++)
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back(); // files saved on windows
+        if (line.empty())
+            continue;
+        if (fileRows == 0)
         {
-            Tile &tile = grid[r][c];
-            if (tile.type == TileType::PATH)
+            // header, until the size is known (# only starts a comment up here, below it is a path tile)
+            if (line[0] == '#')
+                continue;
+            std::istringstream header(line);
+            std::string key;
+            header >> key;
+            if (key == "name")
+                std::getline(header >> std::ws, fileName);
+            else if (key == "size")
+                header >> fileCols >> fileRows;
+            if (key == "size" && (fileCols <= 0 || fileRows <= 0 || fileCols > MAP_MAX_SIZE || fileRows > MAP_MAX_SIZE))
+                return false;
+            continue;
+        }
+        lines.push_back(line);
+    }
+    if (fileRows == 0 || (int)lines.size() < fileRows)
+        return false;
+
+    // keep the current map around, a broken file puts it back untouched
+    int oldRows = rows, oldCols = cols;
+    std::vector<Tile> oldTiles;
+    std::vector<int> oldSpawns, oldExits;
+    oldTiles.swap(tiles);
+    oldSpawns.swap(spawns);
+    oldExits.swap(exits);
+    std::vector<Turret *> oldTurrets;
+    std::vector<unsigned short> oldFreeTurrets;
+    oldTurrets.swap(turret_slots);
+    oldFreeTurrets.swap(free_turret_slots);
+    Resize(fileRows, fileCols);
+    bool ok = true;
+    for (int row = 0; row < fileRows && ok; row++)
+    {
+        if ((int)lines[row].size() < fileCols)
+        {
+            ok = false;
+            break;
+        }
+        for (int col = 0; col < fileCols; col++)
+        {
+            Tile &tile = at(row, col);
+            switch (lines[row][col])
             {
-                DrawRectangleRec(tile.rect, pathColor);
+            case '.':
+                tile.SetType(TileType::BUILDABLE);
+                break;
+            case '#':
+                tile.SetType(TileType::PATH);
+                break;
+            case 'S':
+                tile.SetType(TileType::PATH);
+                spawns.push_back(row * fileCols + col);
+                break;
+            case 'E':
+                tile.SetType(TileType::PATH);
+                exits.push_back(row * fileCols + col);
+                break;
+            default:
+                tile.SetType(TileType::OTHER);
+                break;
             }
-            else if (tile.type == TileType::BUILDABLE)
+        }
+    }
+    if (!ok || !BuildNavigation())
+    {
+        rows = oldRows;
+        cols = oldCols;
+        tiles.swap(oldTiles);
+        spawns.swap(oldSpawns);
+        exits.swap(oldExits);
+        turret_slots.swap(oldTurrets);
+        free_turret_slots.swap(oldFreeTurrets);
+        turrets_version++;
+        // enemy_paths were never replaced, the turrets go back on the coverage one by one
+        ResizeDerived();
+        game->coverage_map.BuildSegments(game->enemy_paths);
+        for (Turret *turret : turret_slots)
+        {
+            if (turret)
+                game->coverage_map.AddTurret(turret->turret, turret->position, turret->range);
+        }
+        return false;
+    }
+    name = fileName;
+    return true;
+}
+
+/* one path per spawn / exit pair that are connected
+ * BFS out from the exit over path tiles, then walk down the distances from the spawn,
+ * going straight whenever that is as short, and keep only the tiles where the direction changes
+ */
+bool Map::BuildWaypoints()
+{
+    std::vector<EnemyPath> paths;
+    if (!FindPaths(nullptr, paths))
+        return false;
+    game->enemy_paths = std::move(paths);
+    game->coverage_map.BuildSegments(game->enemy_paths);
+    return true;
+}
+
+bool Map::PathsFor(const std::vector<TileType> &types, std::vector<EnemyPath> &paths) const
+{
+    return FindPaths(&types, paths);
+}
+
+// types == nullptr goes by the map's own tiles
+bool Map::FindPaths(const std::vector<TileType> *types, std::vector<EnemyPath> &paths) const
+{
+    const int dr[4] = {1, 0, -1, 0};
+    const int dc[4] = {0, 1, 0, -1};
+    auto center = [&](int index) { return Vector2{(index % cols) * TILE_SIZE + TILE_SIZE / 2, (index / cols) * TILE_SIZE + TILE_SIZE / 2}; };
+    auto isPath = [&](int index) { return (types ? (*types)[index] : tiles[index].GetType()) == TileType::PATH; };
+
+    paths.clear();
+    std::vector<int> dist;
+    std::vector<int> queue;
+    for (int exit : exits)
+    {
+        dist.assign(rows * cols, -1);
+        queue.clear();
+        queue.push_back(exit);
+        dist[exit] = 0;
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int index = queue[head];
+            int r = index / cols, c = index % cols;
+            for (int d = 0; d < 4; d++)
             {
-                DrawRectangleRec(tile.rect, buildableColor);
+                int nr = r + dr[d], nc = c + dc[d];
+                if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                    continue;
+                int next = nr * cols + nc;
+                if (dist[next] != -1 || !isPath(next))
+                    continue;
+                dist[next] = dist[index] + 1;
+                queue.push_back(next);
+            }
+        }
+
+        for (int spawn : spawns)
+        {
+            if (dist[spawn] == -1)
+                continue; // can't get there from here
+            EnemyPath path;
+            path.start = center(spawn);
+            int index = spawn;
+            int lastDir = -1;
+            while (index != exit)
+            {
+                int r = index / cols, c = index % cols;
+                // try the current direction first, fewer corners for the same length
+                int order[4];
+                int n = 0;
+                if (lastDir != -1)
+                    order[n++] = lastDir;
+                for (int d = 0; d < 4; d++)
+                {
+                    if (d != lastDir)
+                        order[n++] = d;
+                }
+                int bestDir = -1;
+                for (int d : order)
+                {
+                    int nr = r + dr[d], nc = c + dc[d];
+                    if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                        continue;
+                    if (dist[nr * cols + nc] == dist[index] - 1)
+                    {
+                        bestDir = d;
+                        break;
+                    }
+                }
+                if (bestDir != lastDir && lastDir != -1)
+                    path.waypoints.push_back(center(index)); // corner
+                lastDir = bestDir;
+                index += dr[bestDir] * cols + dc[bestDir];
+            }
+            path.waypoints.push_back(center(exit));
+            // exits on the border lead one tile off the map, so enemies walk out instead of vanishing on the tile
+            int er = exit / cols, ec = exit % cols;
+            Vector2 out = center(exit);
+            if (er == rows - 1)
+                out.y += TILE_SIZE;
+            else if (er == 0)
+                out.y -= TILE_SIZE;
+            else if (ec == cols - 1)
+                out.x += TILE_SIZE;
+            else if (ec == 0)
+                out.x -= TILE_SIZE;
+            if (out.x != center(exit).x || out.y != center(exit).y)
+                path.waypoints.push_back(out);
+            paths.push_back(std::move(path));
+        }
+    }
+    return !paths.empty();
+}
+
+// every path tile walkable, exits at 0, one BFS for the whole map
+void Map::BuildFlowField()
+{
+    game->flow_field.Reset(rows, cols, TILE_SIZE);
+    for (int i = 0; i < rows * cols; i++)
+    {
+        game->flow_field.walkable[i] = tiles[i].GetType() == TileType::PATH;
+    }
+    for (int exit : exits)
+    {
+        game->flow_field.SetExit(exit);
+    }
+    game->flow_field.Build();
+    game->spawn_points.clear();
+    for (int spawn : spawns)
+    {
+        game->spawn_points.push_back(Vector2{(spawn % cols) * TILE_SIZE + TILE_SIZE / 2, (spawn / cols) * TILE_SIZE + TILE_SIZE / 2});
+    }
+}
+
+bool Map::BuildNavigation()
+{
+    if (!BuildWaypoints())
+        return false;
+    BuildFlowField();
+    return true;
+}
+
+bool Map::SetTileType(int row, int col, TileType type)
+{
+    if (row < 0 || col < 0 || row >= rows || col >= cols)
+        return false;
+    int index = row * cols + col;
+    Tile &tile = tiles[index];
+    bool isEnd = std::find(spawns.begin(), spawns.end(), index) != spawns.end() || std::find(exits.begin(), exits.end(), index) != exits.end();
+    if (tile.HasTurret() || isEnd || tile.GetType() == type)
+        return false;
+    TileType before = tile.GetType();
+    tile.SetType(type);
+    game->flow_field.SetWalkable(index, type == TileType::PATH);
+    int touched = game->flow_field.last_update_cells;
+    // every spawn still has to get out somewhere, otherwise put it back
+    for (int spawn : spawns)
+    {
+        if (game->flow_field.dist[spawn] == -1)
+        {
+            tile.SetType(before);
+            game->flow_field.SetWalkable(index, before == TileType::PATH);
+            return false;
+        }
+    }
+    game->flow_field.last_update_cells = touched;
+    MarkDirty(index);
+    // waypoints are a full BFS per exit, only worth it when they're in use (F6 rebuilds them when switching)
+    if (game->nav_mode == NavMode::WAYPOINTS)
+        BuildWaypoints(); // can't fail, every spawn reaches an exit
+    return true;
+}
+
+void Map::VisibleChunks(const Rectangle &view, int &firstRow, int &firstCol, int &lastRow, int &lastCol) const
+{
+    // clamp the visible range of chunks, everything else is off screen
+    const float chunkSize = CHUNK_TILES * TILE_SIZE;
+    firstCol = (int)floorf(view.x / chunkSize);
+    firstRow = (int)floorf(view.y / chunkSize);
+    lastCol = (int)floorf((view.x + view.width) / chunkSize);
+    lastRow = (int)floorf((view.y + view.height) / chunkSize);
+    firstCol = firstCol < 0 ? 0 : firstCol;
+    firstRow = firstRow < 0 ? 0 : firstRow;
+    lastCol = lastCol >= chunk_cols ? chunk_cols - 1 : lastCol;
+    lastRow = lastRow >= chunk_rows ? chunk_rows - 1 : lastRow;
+}
+
+// the tiles of one chunk, offset is added to every tile's world position
+void Map::DrawChunkTiles(int chunk, Vector2 offset)
+{
+    int firstRow = (chunk / chunk_cols) * CHUNK_TILES;
+    int firstCol = (chunk % chunk_cols) * CHUNK_TILES;
+    for (int r = firstRow; r < firstRow + CHUNK_TILES && r < rows; r++)
+    {
+        for (int c = firstCol; c < firstCol + CHUNK_TILES && c < cols; c++)
+        {
+            const Tile &tile = at(r, c);
+            Rectangle rect = {c * TILE_SIZE + offset.x, r * TILE_SIZE + offset.y, TILE_SIZE, TILE_SIZE};
+            if (tile.GetType() == TileType::PATH)
+            {
+                DrawRectangleRec(rect, pathColor);
+            }
+            else if (tile.GetType() == TileType::BUILDABLE)
+            {
+                DrawRectangleRec(rect, buildableColor);
             }
             // grid line with boundary draw
-            DrawRectangleLinesEx(tile.rect, 1, gridLineColor);
+            DrawRectangleLinesEx(rect, 1, gridLineColor);
+        }
+    }
+}
 
-            // highlight on hover
-            if (tile.type == TileType::BUILDABLE && !tile.hasTurret)
+/* redraw the visible chunks that changed (or were never drawn) into their textures
+ * a chunk that needs a texture when all MAX_CACHED_CHUNKS are taken gets the one unused the longest
+ */
+void Map::UpdateCache(const Rectangle &view)
+{
+    cache_frame++;
+    chunks_redrawn = 0;
+    int firstRow, firstCol, lastRow, lastCol;
+    VisibleChunks(view, firstRow, firstCol, lastRow, lastCol);
+    const int chunkPixels = (int)(CHUNK_TILES * TILE_SIZE);
+    for (int cr = firstRow; cr <= lastRow; cr++)
+    {
+        for (int cc = firstCol; cc <= lastCol; cc++)
+        {
+            int chunk = cr * chunk_cols + cc;
+            int slot = chunk_slot[chunk];
+            if (slot == -1)
             {
-                if (CheckCollisionPointRec(GetMousePosition(), tile.rect))
+                if ((int)cache.size() < MAX_CACHED_CHUNKS)
+                {
+                    cache.push_back({LoadRenderTexture(chunkPixels, chunkPixels), -1, 0});
+                    slot = (int)cache.size() - 1;
+                }
+                else
                 {
-                    DrawRectangleRec(tile.rect, mouseHoverColor);
+                    slot = 0;
+                    for (int i = 1; i < (int)cache.size(); i++)
+                    {
+                        if (cache[i].last_used < cache[slot].last_used)
+                            slot = i;
+                    }
+                    if (cache[slot].last_used == cache_frame)
+                        continue; // every texture is on screen already, Draw() does this one tile by tile
+                    chunk_slot[cache[slot].chunk] = -1;
                 }
+                cache[slot].chunk = chunk;
+                chunk_slot[chunk] = slot;
+                chunk_dirty[chunk] = 1;
             }
+            cache[slot].last_used = cache_frame;
+            if (!chunk_dirty[chunk])
+                continue;
+            BeginTextureMode(cache[slot].texture);
+            ClearBackground(BLANK);
+            DrawChunkTiles(chunk, {-(float)cc * chunkPixels, -(float)cr * chunkPixels});
+            EndTextureMode();
+            chunk_dirty[chunk] = 0;
+            chunks_redrawn++;
         }
     }
 }
 
+void Map::UnloadCache()
+{
+    for (auto &cached : cache)
+    {
+        UnloadRenderTexture(cached.texture);
+    }
+    cache.clear();
+    std::fill(chunk_slot.begin(), chunk_slot.end(), -1);
+    std::fill(chunk_dirty.begin(), chunk_dirty.end(), 1);
+}
+
+void Map::Draw(const Rectangle &view, Vector2 mouseWorld)
+{
+    int firstRow, firstCol, lastRow, lastCol;
+    VisibleChunks(view, firstRow, firstCol, lastRow, lastCol);
+    const float chunkPixels = CHUNK_TILES * TILE_SIZE;
+    for (int cr = firstRow; cr <= lastRow; cr++)
+    {
+        for (int cc = firstCol; cc <= lastCol; cc++)
+        {
+            int chunk = cr * chunk_cols + cc;
+            int slot = chunk_slot[chunk];
+            if (slot == -1 || chunk_dirty[chunk])
+            {
+                DrawChunkTiles(chunk, {0, 0});
+                continue;
+            }
+            // render textures are upside down, hence the negative height
+            Texture2D &texture = cache[slot].texture.texture;
+            DrawTextureRec(texture, {0, 0, (float)texture.width, -(float)texture.height}, {cc * chunkPixels, cr * chunkPixels}, WHITE);
+        }
+    }
+
+    // highlight on hover
+    Tile *hovered = getTileFromMouse(mouseWorld);
+    if (hovered && hovered->GetType() == TileType::BUILDABLE && !hovered->HasTurret())
+    {
+        DrawRectangleRec(TileRect(hovered), mouseHoverColor);
+    }
+}
+
+void Map::PlaceTurret(Tile *tile, Turret *turret)
+{
+    if (tile->turret)
+        RemoveTurret(tile);
+    unsigned short slot;
+    if (!free_turret_slots.empty())
+    {
+        slot = free_turret_slots.back();
+        free_turret_slots.pop_back();
+        turret_slots[slot] = turret;
+    }
+    else
+    {
+        slot = (unsigned short)turret_slots.size();
+        turret_slots.push_back(turret);
+    }
+    tile->turret = slot + 1;
+    tile->SetHasTurret(true);
+    game->coverage_map.AddTurret(turret->turret, turret->position, turret->range);
+    turrets_version++;
+}
+
+void Map::RemoveTurret(Tile *tile)
+{
+    if (tile->turret)
+    {
+        Turret *turret = turret_slots[tile->turret - 1];
+        game->coverage_map.RemoveTurret(turret->turret, turret->position, turret->range);
+        turret_slots[tile->turret - 1] = nullptr;
+        free_turret_slots.push_back(tile->turret - 1);
+    }
+    tile->turret = 0;
+    tile->SetHasTurret(false);
+    turrets_version++;
+}
+
+void Map::ClearTurrets()
+{
+    for (Tile &tile : tiles)
+    {
+        tile.turret = 0;
+        tile.SetHasTurret(false);
+    }
+    turret_slots.clear();
+    free_turret_slots.clear();
+    game->coverage_map.Clear();
+    turrets_version++;
+}
+
 Tile *Map::getTileFromMouse(Vector2 pos)
 {
-    int col = pos.x > GRID_COLS * TILE_SIZE ? -1 : pos.x / TILE_SIZE;
-    int row = pos.y > GRID_ROWS * TILE_SIZE ? -1 : pos.y / TILE_SIZE;
+    // with the camera moved around, pos can be anywhere, negative included
+    if (pos.x < 0 || pos.y < 0)
+        return nullptr;
+    int col = pos.x >= cols * TILE_SIZE ? -1 : pos.x / TILE_SIZE;
+    int row = pos.y >= rows * TILE_SIZE ? -1 : pos.y / TILE_SIZE;
     if (row > -1 && col > -1)
     {
-        return &grid[row][col];
+        return &at(row, col);
     }
     return nullptr;
 }
+
+void Map::SaveTiles(BinaryWriter &out)
+{
+    out.Write((unsigned short)rows);
+    out.Write((unsigned short)cols);
+    unsigned char bits = 0;
+    int count = 0;
+    for (const Tile &tile : tiles)
+    {
+        if (tile.HasTurret())
+            bits |= 1 << (count % 8);
+        count++;
+        if (count % 8 == 0)
+        {
+            out.Write(bits);
+            bits = 0;
+        }
+    }
+    if (count % 8 != 0)
+        out.Write(bits);
+    // tile types too, the map can be edited while playing, 4 tiles per byte
+    bits = 0;
+    count = 0;
+    for (const Tile &tile : tiles)
+    {
+        bits |= (unsigned char)tile.GetType() << (2 * (count % 4));
+        count++;
+        if (count % 4 == 0)
+        {
+            out.Write(bits);
+            bits = 0;
+        }
+    }
+    if (count % 4 != 0)
+        out.Write(bits);
+}
+
+// reads into occupied / types without touching the map, so a broken snapshot changes nothing
+bool Map::LoadTiles(BinaryReader &in, std::vector<bool> &occupied, std::vector<TileType> &types)
+{
+    int savedRows = in.Read<unsigned short>();
+    int savedCols = in.Read<unsigned short>();
+    if (!in.ok || savedRows != rows || savedCols != cols)
+        return false;
+    occupied.assign(rows * cols, false);
+    unsigned char bits = 0;
+    for (int i = 0; i < rows * cols; i++)
+    {
+        if (i % 8 == 0)
+            bits = in.Read<unsigned char>();
+        occupied[i] = (bits >> (i % 8)) & 1;
+    }
+    types.assign(rows * cols, TileType::BUILDABLE);
+    for (int i = 0; i < rows * cols; i++)
+    {
+        if (i % 4 == 0)
+            bits = in.Read<unsigned char>();
+        types[i] = (TileType)((bits >> (2 * (i % 4))) & 3);
+    }
+    return in.ok;
+}
+
+// turrets lose their handles here, whoever loaded them has to PlaceTurret them again
+bool Map::ApplyTiles(const std::vector<bool> &occupied, const std::vector<TileType> &types)
+{
+    bool changed = false;
+    for (size_t i = 0; i < tiles.size() && !changed; i++)
+        changed = tiles[i].GetType() != types[i];
+    // edited since the snapshot, paths and field get rebuilt from scratch, but only if there are any
+    std::vector<EnemyPath> paths;
+    if (changed && !PathsFor(types, paths))
+        return false;
+    ClearTurrets();
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        tiles[i].SetHasTurret(occupied[i]);
+        if (tiles[i].GetType() != types[i])
+            MarkDirty((int)i);
+        tiles[i].SetType(types[i]);
+    }
+    // can't fail, the same tiles just gave paths
+    if (changed && !BuildNavigation())
+        return false;
+    return true;
+}
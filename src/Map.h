@@ -1,34 +1,143 @@
 #pragma once
 #include "Config.h"
+#include "Serialize.h"
 #include "raylib.h"
+#include <algorithm>
+#include <string>
 #include <vector>
 class Entity;
+class Turret;
 
-enum class TileType
+enum class TileType : unsigned char
 {
     PATH,
     BUILDABLE,
     OTHER
 };
 
+/* One tile, 4 bytes
+ * type and the turret flag share one byte, turret is a handle into Map's turret table
+ * the rectangle follows from where the tile is in Map::tiles, Map::TileRect() works it out
+ */
 struct Tile
 {
-    Rectangle rect;
-    TileType type = TileType::BUILDABLE;
-    bool hasTurret = false;
-    Color color;
+    unsigned char bits = (unsigned char)TileType::BUILDABLE; // bits 0-1 type, bit 2 has a turret
+    unsigned short turret = 0;                               // 1 + slot in Map::turret_slots, 0 = none
+
+    TileType GetType() const { return (TileType)(bits & 3); }
+    void SetType(TileType type) { bits = (bits & ~3) | (unsigned char)type; }
+    bool HasTurret() const { return bits & 4; }
+    void SetHasTurret(bool has) { bits = has ? (bits | 4) : (bits & ~4); }
 };
 
+/* Map file (.ozm), plain text so it can be made in any editor
+ *   # comment                   (only before size)
+ *   name <anything>
+ *   size <cols> <rows>          up to MAP_MAX_SIZE each way
+ *   <rows lines of cols characters>
+ *     . buildable   # path   x nothing (can't build, can't walk)
+ *     S spawn (path) E exit (path), as many of each as you like
+ * Every spawn gets a path to every exit it can reach, enemies take turns between them.
+ * The paths themselves are found with a BFS over path tiles, only the corners are kept as waypoints.
+ * The flow field (FlowField.h) is built from the same tiles, for the other way of getting enemies around.
+ */
 class Map
 {
   public:
-    std::vector<std::vector<Tile>> grid; // 2D grid of tiles
+    int rows = 0;
+    int cols = 0;
+    std::vector<Tile> tiles; // rows * cols, row by row, tiles[row * cols + col]
+    std::string name;
+    std::vector<int> spawns; // row * cols + col of the S and E tiles
+    std::vector<int> exits;
     const Color pathColor = Color{100, 100, 100, 255};
     const Color buildableColor = Color{80, 80, 80, 255};
     const Color gridLineColor = Color{60, 60, 60, 100}; // colour of border of each tile
 
+    // empty, LoadFromFile() or BuildDefault() (the built-in serpentine map) fill it in
+    // both work out the paths and the flow field for the game this thread is on, see GameState
     Map();
 
+    Tile &at(int row, int col) { return tiles[row * cols + col]; }
+    int IndexOf(const Tile *tile) const { return (int)(tile - tiles.data()); }
+    Rectangle TileRect(const Tile *tile) const
+    {
+        int index = IndexOf(tile);
+        return {(index % cols) * TILE_SIZE, (index / cols) * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+    }
+    Vector2 TileCenter(const Tile *tile) const
+    {
+        Rectangle rect = TileRect(tile);
+        return {rect.x + rect.width / 2, rect.y + rect.height / 2};
+    }
     Tile *getTileFromMouse(Vector2 pos);
-    void Draw();
+
+    /* tile <-> turret, both ways O(1): the tile holds a handle, the turret holds its tile
+     * PlaceTurret also sets the turret flag, RemoveTurret clears it, and both update coverage_map
+     */
+    void PlaceTurret(Tile *tile, Turret *turret);
+    void RemoveTurret(Tile *tile);
+    unsigned int turrets_version = 0; // goes up on every place / remove, for anything cached from where turrets are
+    Turret *TurretOn(const Tile *tile) const { return tile->turret ? turret_slots[tile->turret - 1] : nullptr; }
+    void ClearTurrets();
+
+    /* the tiles are drawn into cached textures, CHUNK_TILES x CHUNK_TILES tiles each, and only redrawn when dirty
+     * UpdateCache() has to run outside BeginMode2D (it switches render targets), Draw() inside it
+     * view => world rectangle seen by the camera, only chunks inside it are touched
+     * mouseWorld => mouse in world coordinates, for the hover highlight
+     */
+    static const int CHUNK_TILES = 8;
+    static const int MAX_CACHED_CHUNKS = 64; // 400 KB each, past this chunks are drawn tile by tile
+    int chunks_redrawn = 0;                  // last UpdateCache, for the HUD
+    void UpdateCache(const Rectangle &view);
+    void Draw(const Rectangle &view, Vector2 mouseWorld);
+    void MarkDirty(int index) { chunk_dirty[(index / cols) / CHUNK_TILES * chunk_cols + (index % cols) / CHUNK_TILES] = 1; }
+    void MarkAllDirty() { std::fill(chunk_dirty.begin(), chunk_dirty.end(), 1); }
+    void UnloadCache();
+
+    // replaces this map with the one in path, leaves it alone (and returns false) if the file is missing or broken
+    bool LoadFromFile(const char *path);
+    void BuildDefault();
+    /* change one tile on a live map (PATH <-> BUILDABLE), the flow field is patched instead of rebuilt
+     * refused for spawns, exits, tiles with a turret, and anything that would wall a spawn off from every exit
+     */
+    bool SetTileType(int row, int col, TileType type);
+
+    // which tiles have a turret on them (one bit each) and their types (two bits each), row by row
+    // the size and the spawns / exits come from the map file, not the snapshot
+    void SaveTiles(BinaryWriter &out);
+    bool LoadTiles(BinaryReader &in, std::vector<bool> &occupied, std::vector<TileType> &types);
+    // false (and the map left alone) if no spawn reaches an exit on the loaded tiles
+    bool ApplyTiles(const std::vector<bool> &occupied, const std::vector<TileType> &types);
+
+    // enemy_paths for NavMode::WAYPOINTS, flow_field and spawn_points for NavMode::FLOW_FIELD
+    bool BuildWaypoints();
+    // the paths BuildWaypoints would make on these tile types, without touching the map or the game
+    bool PathsFor(const std::vector<TileType> &types, std::vector<EnemyPath> &paths) const;
+
+  private:
+    std::vector<Turret *> turret_slots;
+    std::vector<unsigned short> free_turret_slots;
+
+    // chunk cache, chunk_slot[chunk] is where its texture is in cache (-1 = none)
+    struct CachedChunk
+    {
+        RenderTexture2D texture;
+        int chunk;
+        unsigned long long last_used;
+    };
+    int chunk_rows = 0;
+    int chunk_cols = 0;
+    std::vector<unsigned char> chunk_dirty;
+    std::vector<int> chunk_slot;
+    std::vector<CachedChunk> cache;
+    unsigned long long cache_frame = 0;
+    void VisibleChunks(const Rectangle &view, int &firstRow, int &firstCol, int &lastRow, int &lastCol) const;
+    void DrawChunkTiles(int chunk, Vector2 offset);
+
+    void Resize(int newRows, int newCols);
+    void ResizeDerived();
+    void BuildFlowField();
+    bool BuildNavigation();
+    bool FindPaths(const std::vector<TileType> *types, std::vector<EnemyPath> &paths) const;
 };
@@ -0,0 +1,165 @@
+#include "Metrics.h"
+#include "StatsManager.h"
+#include "raylib.h"
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#ifdef _WIN32
+// no winsock version yet, the game runs the same without it
+bool MetricsServer::Start(int port)
+{
+    TraceLog(LOG_WARNING, "METRICS: not available on this platform, port %d ignored", port);
+    return false;
+}
+void MetricsServer::Stop() {}
+void MetricsServer::ServeLoop() {}
+#else
+bool MetricsServer::Start(int port)
+{
+    Stop();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local only, nothing here is meant for the network
+    if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0)
+    {
+        TraceLog(LOG_WARNING, "METRICS: could not listen on 127.0.0.1:%d", port);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    listenFd = fd;
+    stopping = false;
+    server = thread(&MetricsServer::ServeLoop, this);
+    TraceLog(LOG_INFO, "METRICS: serving http://127.0.0.1:%d/metrics", port);
+    return true;
+}
+
+void MetricsServer::Stop()
+{
+    if (listenFd < 0)
+        return;
+    stopping = true;
+    server.join();
+    close(listenFd);
+    listenFd = -1;
+}
+
+void MetricsServer::ServeLoop()
+{
+    string body, response;
+    while (!stopping)
+    {
+        // woken up now and then to see if it should stop
+        pollfd waiting = {listenFd, POLLIN, 0};
+        if (poll(&waiting, 1, 200) <= 0)
+            continue;
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        // a client that never sends its request doesn't get to hold the thread
+        timeval timeout = {1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        ssize_t got = recv(client, request, sizeof(request) - 1, 0);
+        if (got > 0)
+        {
+            request[got] = 0;
+            const char *status = "200 OK";
+            if (!strncmp(request, "GET /metrics ", 13) || !strncmp(request, "GET / ", 6))
+                Format(snapshots.Read(), body);
+            else
+            {
+                status = "404 Not Found";
+                body = "try /metrics\n";
+            }
+            char header[256];
+            snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", status, body.size());
+            response = header;
+            response += body;
+            size_t sent = 0;
+            while (sent < response.size())
+            {
+                ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                    break;
+                sent += (size_t)n;
+            }
+        }
+        close(client);
+    }
+}
+#endif
+
+void MetricsServer::Format(const MetricsSnapshot &s, string &out)
+{
+    char line[256];
+    out.clear();
+    auto metric = [&](const char *name, const char *type, const char *help) {
+        snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+        out += line;
+    };
+    auto value = [&](const char *name, const char *labels, double v) {
+        snprintf(line, sizeof(line), "%s%s %.17g\n", name, labels, v);
+        out += line;
+    };
+    char labels[128];
+
+    metric("outpost_entities", "gauge", "Live entities by kind and type");
+    for (int i = 0; i < ENEMY_TYPE_COUNT; i++)
+    {
+        snprintf(labels, sizeof(labels), "{kind=\"enemy\",type=\"%s\"}", StatsManager::EnemyName((EnemyType)i));
+        value("outpost_entities", labels, s.enemies[i]);
+    }
+    for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+    {
+        snprintf(labels, sizeof(labels), "{kind=\"turret\",type=\"%s\"}", StatsManager::TurretName((TurretType)i));
+        value("outpost_entities", labels, s.turrets[i]);
+    }
+    value("outpost_entities", "{kind=\"projectile\",type=\"all\"}", s.projectiles);
+    metric("outpost_particles", "gauge", "Live particles");
+    value("outpost_particles", "", s.particles);
+    metric("outpost_enemies_parked", "gauge", "Enemies left out of ticks by the sim LOD");
+    value("outpost_enemies_parked", "", s.parked);
+    metric("outpost_turrets_awake", "gauge", "Turrets that targeted in the last tick");
+    value("outpost_turrets_awake", "", s.turretsAwake);
+
+    metric("outpost_frame_phase_ms", "gauge", "CPU time of the last frame by phase, in milliseconds");
+    value("outpost_frame_phase_ms", "{phase=\"input\"}", s.inputMs);
+    value("outpost_frame_phase_ms", "{phase=\"update\"}", s.updateMs);
+    value("outpost_frame_phase_ms", "{phase=\"draw\"}", s.drawMs);
+    value("outpost_frame_phase_ms", "{phase=\"gui\"}", s.guiMs);
+    metric("outpost_frame_ms", "gauge", "Last whole frame, in milliseconds");
+    value("outpost_frame_ms", "", s.frameMs);
+    metric("outpost_ticks_per_second", "gauge", "Simulated ticks per second of wall time, smoothed");
+    value("outpost_ticks_per_second", "", s.ticksPerSecond);
+    // the game's own tick and kills go back on rewind, quickload and new game, so they're gauges,
+    // a counter going down reads as a reset to rate() / increase()
+    metric("outpost_sim_tick", "gauge", "Current tick of the game, goes back on rewind and quickload");
+    value("outpost_sim_tick", "", (double)s.simTick);
+    metric("outpost_sim_ticks_total", "counter", "Ticks simulated since startup, played or resolved, rewinds don't take any back");
+    value("outpost_sim_ticks_total", "", (double)s.ticksSimulated);
+
+    metric("outpost_wave", "gauge", "Current wave number");
+    value("outpost_wave", "", s.wave);
+    metric("outpost_money", "gauge", "Player money");
+    value("outpost_money", "", s.money);
+    metric("outpost_health", "gauge", "Player health");
+    value("outpost_health", "", s.health);
+    metric("outpost_enemies_killed", "gauge", "Enemies killed in this game, goes back on rewind and quickload");
+    value("outpost_enemies_killed", "", s.kills);
+    metric("outpost_snapshots_published_total", "counter", "Frames that published metrics, stalls show up as this not moving");
+    value("outpost_snapshots_published_total", "", (double)s.published);
+}
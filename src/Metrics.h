@@ -0,0 +1,90 @@
+#pragma once
+#include "Types.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+/* Local metrics endpoint for long sessions (soak tests, bots): Prometheus text format on
+ * http://127.0.0.1:<port>/metrics, main.cpp takes --metrics <port>.
+ * The game fills a MetricsSnapshot once a frame and publishes it, the server thread only ever
+ * reads the last one published, so a scrape never touches live game state or waits on the frame,
+ * and the frame never waits on a scrape.
+ */
+struct MetricsSnapshot
+{
+    int enemies[ENEMY_TYPE_COUNT] = {};
+    int turrets[TURRET_TYPE_COUNT] = {};
+    int projectiles = 0;
+    int particles = 0;
+    int parked = 0;       // sim LOD
+    int turretsAwake = 0;
+    // cpu time of the frame phases in Game(), drawing is only what it takes to queue it up for the gpu
+    double inputMs = 0, updateMs = 0, drawMs = 0, guiMs = 0;
+    double frameMs = 0;      // whole frame, vsync wait included
+    float ticksPerSecond = 0; // simulated ticks per wall second, smoothed
+    unsigned long long simTick = 0;         // the game's tick, goes back on rewind / quickload / new game
+    unsigned long long ticksSimulated = 0;  // every tick this process ran (played or resolved), only ever goes up
+    int wave = 0;
+    int money = 0;
+    int health = 0;
+    int kills = 0; // this game's, also goes back with the game
+    unsigned long long published = 0; // goes up by one every Publish
+};
+
+/* one writer, one reader, newest value wins, no locks and nobody waits:
+ * the writer fills its own slot and swaps it with the middle one, the reader swaps the middle one
+ * with its own when the writer has put something new there
+ */
+template <typename T>
+class TripleBuffer
+{
+  public:
+    T &Back() { return slots[back]; }
+    void Publish() { back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX; }
+    const T &Read()
+    {
+        if (middle.load(std::memory_order_relaxed) & FRESH)
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return slots[front];
+    }
+
+  private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+    T slots[3];
+    int back = 0;  // writer's
+    int front = 1; // reader's
+    std::atomic<int> middle{2};
+};
+
+class MetricsServer
+{
+  public:
+    MetricsServer() {}
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+    ~MetricsServer() { Stop(); }
+
+    // listens on 127.0.0.1:port only, false (and a warning) if it can't
+    bool Start(int port);
+    void Stop();
+    bool IsRunning() const { return listenFd >= 0; }
+
+    // game thread: fill Next(), then Publish()
+    MetricsSnapshot &Next() { return snapshots.Back(); }
+    void Publish()
+    {
+        snapshots.Back().published = ++published;
+        snapshots.Publish();
+    }
+
+  private:
+    TripleBuffer<MetricsSnapshot> snapshots;
+    unsigned long long published = 0;
+    int listenFd = -1;
+    std::thread server;
+    std::atomic<bool> stopping{false};
+
+    void ServeLoop();
+    static void Format(const MetricsSnapshot &s, std::string &out);
+};
@@ -2,6 +2,7 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "Types.h"
+#include "rlgl.h"
 #include <cmath>
 #include <vector>
 
@@ -15,6 +16,7 @@ struct Particle
     Color color;
     float size;
     ProjectileType proj_type;
+    float damping; // velocity kept per update, stream puffs keep all of it so they reach the end of the cone
 };
 
 class ParticleSystem
@@ -22,41 +24,115 @@ class ParticleSystem
   public:
     std::vector<Particle> particles;
 
+    // debug: F3 in game switches between the batched quads and the old DrawCircleV path
+    bool batched = true;
+    double last_draw_ms = 0.0; // cpu time of the last Draw(), including pushing the batch to the gpu
+    bool suppressed = false;   // nothing spawns while set, for simulating without drawing
+
+    /* Load budget, 1 = everything, down to MIN_BUDGET when frames run long.
+     * Scales how often trails spawn, how many particles an explosion gets and the live particle cap.
+     * Goes by the work done in a frame (update + draw), not GetFrameTime(): with vsync and SetTargetFPS(60)
+     * the frame time never drops under 1/60 s however light the load is, so nothing would ever come back.
+     * Drops fast when the work gets near the frame and comes back slowly once it's well under it,
+     * the gap between the two keeps it from flickering.
+     */
+    float budget = 1.0f;
+    static constexpr float TARGET_FRAME_TIME = 1.0f / 60.0f;
+    static constexpr float SHED_ABOVE = 0.9f * TARGET_FRAME_TIME;    // the swap and the gpu need the rest
+    static constexpr float RECOVER_BELOW = 0.75f * TARGET_FRAME_TIME;
+    static constexpr float MIN_BUDGET = 0.1f;
+    static constexpr int MAX_PARTICLES = 50000;      // live cap at full budget
+    static constexpr float MERGE_RADIUS = 24.0f;     // explosions closer than this in one frame become one, when under load
+
+    // once per frame, with the cpu time the last frame took before waiting on the frame pacing
+    void Adapt(float workTime)
+    {
+        // smooth it a bit, one slow frame (loading, window drag) shouldn't kill all effects
+        smoothed_work_time += (workTime - smoothed_work_time) * 0.1f;
+        if (smoothed_work_time > SHED_ABOVE)
+        {
+            budget = fmaxf(MIN_BUDGET, budget * 0.95f);
+        }
+        else if (smoothed_work_time < RECOVER_BELOW)
+        {
+            budget = fminf(1.0f, budget + 0.005f); // about 3 seconds from minimum back to full
+        }
+        explosions_this_frame.clear();
+    }
+    int GetParticleCap() const { return (int)(MAX_PARTICLES * budget); }
+
     void Update(float deltaTime)
     {
-        for (auto it = particles.begin(); it != particles.end();)
+        // swap-and-pop instead of erase, order doesn't matter for additive blending
+        // and erase in the middle made this O(n^2) with lots of particles
+        size_t i = 0;
+        while (i < particles.size())
         {
-            it->life -= deltaTime;
-            if (it->life <= 0)
+            Particle &p = particles[i];
+            p.life -= deltaTime;
+            if (p.life <= 0)
             {
-                it = particles.erase(it); // returns an iterator to the next element after the one destroyed
+                p = particles.back();
+                particles.pop_back();
             }
             else
             {
-                it->pos = Vector2Add(it->pos, Vector2Scale(it->vel, deltaTime));
-                it->vel = Vector2Scale(it->vel, 0.9f);
-                ++it;
+                p.pos = Vector2Add(p.pos, Vector2Scale(p.vel, deltaTime));
+                p.vel = Vector2Scale(p.vel, p.damping);
+                ++i;
             }
         }
     }
 
-    void Draw()
+    // only particles inside view (world coordinates) get drawn
+    void Draw(const Rectangle &view)
     {
+        double start = GetTime();
         BeginBlendMode(BLEND_ADDITIVE);
-        for (const auto &p : particles)
+        if (batched && dotTexture.id != 0)
         {
-            float alpha = p.life / p.max_life; // how much to fade depending on fraction of life left
-            DrawCircleV(p.pos, p.size, Fade(p.color, alpha));
+            DrawBatched(view);
         }
+        else
+        {
+            for (const auto &p : particles)
+            {
+                if (!InView(p, view))
+                    continue;
+                float alpha = p.life / p.max_life; // how much to fade depending on fraction of life left
+                DrawCircleV(p.pos, p.size, Fade(p.color, alpha));
+            }
+        }
+        // push whatever is queued now, so the timing includes it
+        rlDrawRenderBatchActive();
         EndBlendMode();
+        last_draw_ms = (GetTime() - start) * 1000.0;
     }
-    void Spawn(Vector2 pos, Vector2 vel, Color color, float life, float size, ProjectileType proj_type)
+
+    // soft dot, white in the middle fading to nothing, tinted per particle, one for every game
+    static void LoadTextures()
+    {
+        Image dot = GenImageGradientRadial(32, 32, 0.0f, WHITE, BLANK);
+        dotTexture = LoadTextureFromImage(dot);
+        UnloadImage(dot);
+    }
+    static void DestroyTextures()
+    {
+        UnloadTexture(dotTexture);
+        dotTexture.id = 0;
+    }
+    void Spawn(Vector2 pos, Vector2 vel, Color color, float life, float size, ProjectileType proj_type, float damping = 0.9f)
     {
         // placeholder for formattin
-        particles.push_back({pos, vel, life, life, color, size, proj_type});
+        if (suppressed || (int)particles.size() >= GetParticleCap())
+            return;
+        particles.push_back({pos, vel, life, life, color, size, proj_type, damping});
     }
     void SpawnExplosion(Vector2 center, ProjectileType proj_type)
     {
+        // straight out when suppressed, so headless games never touch raylib's random numbers (one generator, shared by every thread)
+        if (suppressed)
+            return;
 
         int num_particles; // control number of particles per explosion
         float speed;
@@ -116,6 +192,19 @@ class ParticleSystem
         }
         }
 
+        if (budget < 1.0f && num_particles > 0)
+        {
+            // under load, an explosion right next to one from this frame is just skipped,
+            // in a crowd they'd all overlap into the same blob anyway
+            for (const Vector2 &other : explosions_this_frame)
+            {
+                if (Vector2DistanceSqr(center, other) < MERGE_RADIUS * MERGE_RADIUS)
+                    return;
+            }
+            explosions_this_frame.push_back(center);
+            num_particles = (int)ceilf(num_particles * budget);
+        }
+
         for (int i = 0; i < num_particles; i++)
         {
             Vector2 dir = {cosf(GetRandomValue(0, 360) * DEG2RAD), sinf(GetRandomValue(0, 360) * DEG2RAD)};
@@ -126,13 +215,96 @@ class ParticleSystem
 
     void SpawnTrail(Vector2 pos, Vector2 vel, ProjectileType proj_type)
     {
+        if (suppressed)
+            return;
+        // with a lower budget only every few calls leaves a trail particle
+        trail_accumulator += budget;
+        if (trail_accumulator < 1.0f)
+            return;
+        trail_accumulator -= 1.0f;
         Color c = {235, 140, 108, 255};
         Vector2 jitter = {GetRandomValue(-10, 0) / 100.0f, GetRandomValue(-10, 0) / 100.0f};
         Spawn(pos, Vector2Add(vel, jitter), c, 0.2f, 2.0f, proj_type);
     }
     
+    /* what's left of the ripple/salvo projectiles, purely visual
+     * one puff per call flying out along dir with some jitter, fading out by the time it reaches range
+     */
+    void SpawnStream(Vector2 origin, Vector2 dir, float speed, float spreadDeg, float range, Color color, ProjectileType proj_type)
+    {
+        if (suppressed)
+            return;
+        stream_accumulator += budget;
+        if (stream_accumulator < 1.0f)
+            return;
+        stream_accumulator -= 1.0f;
+        float jitter = GetRandomValue(-100, 100) / 100.0f * spreadDeg * DEG2RAD;
+        float puff_speed = speed * (1 - (GetRandomValue(-10, 10) / 100.0f)); // +- 10% like the old flame bullets
+        Vector2 vel = Vector2Scale(Vector2Rotate(dir, jitter), puff_speed);
+        Spawn(origin, vel, color, range / puff_speed, 5.0f, proj_type, 1.0f);
+    }
+
     void cleanup()
     {
         particles.clear();
+        explosions_this_frame.clear();
+        budget = 1.0f;
+        trail_accumulator = 0.0f;
+        stream_accumulator = 0.0f;
+        smoothed_work_time = 0.0f;
+    }
+
+  private:
+    inline static Texture2D dotTexture = {0};
+    float smoothed_work_time = 0.0f;
+    float trail_accumulator = 0.0f;
+    float stream_accumulator = 0.0f;
+    std::vector<Vector2> explosions_this_frame;
+    // quads per rlBegin/rlEnd, well under rlgl's default batch size (8192 quads)
+    static const int QUADS_PER_CHUNK = 1024;
+
+    static bool InView(const Particle &p, const Rectangle &view)
+    {
+        return !(p.pos.x + p.size < view.x || p.pos.x - p.size > view.x + view.width || p.pos.y + p.size < view.y || p.pos.y - p.size > view.y + view.height);
+    }
+
+    /* Every particle is one textured quad, all in the same texture and blend mode
+     * so rlgl keeps them in one draw call per full batch, instead of a tessellated circle each.
+     * The dot fades out towards its edge, so the quad is drawn a bit bigger than the old circle.
+     * At 50k particles that's 7 draw calls a frame instead of 110 (DrawCircleV is 18 quads a circle),
+     * and about 1 ms of cpu instead of 30-65 ms.
+     */
+    void DrawBatched(const Rectangle &view)
+    {
+        size_t i = 0;
+        while (i < particles.size())
+        {
+            // make room for a whole chunk up front, rlgl flushes here if it has to
+            rlCheckRenderBatchLimit(4 * QUADS_PER_CHUNK);
+            rlSetTexture(dotTexture.id);
+            rlBegin(RL_QUADS);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            int quads = 0;
+            for (; i < particles.size() && quads < QUADS_PER_CHUNK; i++)
+            {
+                const Particle &p = particles[i];
+                if (!InView(p, view))
+                    continue;
+                float alpha = p.life / p.max_life;
+                float half = p.size * 1.5f;
+                rlColor4ub(p.color.r, p.color.g, p.color.b, (unsigned char)(p.color.a * alpha));
+                rlTexCoord2f(0.0f, 0.0f);
+                rlVertex2f(p.pos.x - half, p.pos.y - half);
+                rlTexCoord2f(0.0f, 1.0f);
+                rlVertex2f(p.pos.x - half, p.pos.y + half);
+                rlTexCoord2f(1.0f, 1.0f);
+                rlVertex2f(p.pos.x + half, p.pos.y + half);
+                rlTexCoord2f(1.0f, 0.0f);
+                rlVertex2f(p.pos.x + half, p.pos.y - half);
+                quads++;
+            }
+            rlEnd();
+            rlSetTexture(0);
+        }
     }
 };
@@ -1,6 +1,8 @@
 #pragma once
+#include "Bodies.h"
 #include "Config.h"
 #include "Entity.h"
+#include "GameState.h"
 #include "Types.h"
 #include "Particles.h"
 #include "raylib.h"
@@ -11,25 +13,50 @@
 class Projectile : public Entity
 {
   public: 
-    float radius;                 
     bool active;                
-    Vector2 start_pos;           
     Vector2 target_pos;          
     int pierce_count;          
     std::unordered_set<int> current_colliding; // to not hit same enemy twice
     unsigned long long id;     
     int enemies_hit = 0;
+    int source = -1; // stats slot of the turret that fired it
+    /* position, velocity, radius and where it was fired from live in the game's projectile table,
+     * MoveProjectiles and CollideProjectiles (Systems.cpp) fly it and hit things with it
+     * the subclass constructors set radius and range, a lancer bullet also holds back BODY_MOVING until it's out of the gun
+     */
     Projectile(Vector2 startPos, Vector2 targetPos)
     {
-        id = next_id++;
-        start_pos = startPos;
+        kind = EntityKind::PROJECTILE;
+        bodies = &game->projectile_bodies;
+        body = bodies->Add(this, BODY_ACTIVE | BODY_MOVING);
+        id = game->next_projectile_id++;
+        SetStartPos(startPos);
         target_pos = targetPos;
-        position = startPos; 
+        SetPosition(startPos);
+        bodies->last_x[body] = startPos.x;
+        bodies->last_y[body] = startPos.y;
         active = true;       
     }
+    ~Projectile() { bodies->Remove(body); }
     virtual ProjectileType getProjType() = 0; 
     virtual float GetMaxProjRange() = 0;      
-    float GetRadius() const { return radius; }
+    Vector2 GetPosition() const final { return bodies->Position(body); }
+    Vector2 GetVelocity() const final { return bodies->Velocity(body); }
+    void SetPosition(Vector2 pos) final { bodies->SetPosition(body, pos); }
+    void SetVelocity(Vector2 vel) final { bodies->SetVelocity(body, vel); }
+    float GetRadius() const { return bodies->radius[body]; }
+    void SetRadius(float r) { bodies->radius[body] = r; }
+    Vector2 GetStartPos() const { return {bodies->start_x[body], bodies->start_y[body]}; }
+    void SetStartPos(Vector2 pos)
+    {
+        bodies->start_x[body] = pos.x;
+        bodies->start_y[body] = pos.y;
+    }
+    void Destroy() override
+    {
+        is_active = false;
+        bodies->SetFlag(body, BODY_ACTIVE, false);
+    }
     void ReducePierceCount()
     {
         pierce_count--;
@@ -39,18 +66,49 @@ class Projectile : public Entity
             Destroy();
         }
     }
+    // after MoveProjectiles, what's left is the trail behind it
     void Update(float deltaTime) override
     {
-        // delete projectile if too far from firing pos;
-        if (Vector2DistanceSqr(position, start_pos) > GetMaxProjRange())
+        if (IsActive())
+            game->particles.SpawnTrail(GetPosition(), GetVelocity(), getProjType());
+    }
+    void Draw() override {/* empty because no need to draw anything for this class */} 
+
+    void Save(BinaryWriter &out) override
+    {
+        Entity::Save(out);
+        out.Write(GetRadius());
+        out.WriteBool(active);
+        out.Write(GetStartPos());
+        out.Write(target_pos);
+        out.Write(pierce_count);
+        out.Write(id);
+        out.Write(enemies_hit);
+        out.Write(source);
+        out.Write((unsigned int)current_colliding.size());
+        for (int enemy_id : current_colliding)
         {
-            Destroy();
-            return;
+            out.Write(enemy_id);
+        }
+    }
+    void Load(BinaryReader &in) override
+    {
+        Entity::Load(in);
+        SetRadius(in.Read<float>());
+        active = in.ReadBool();
+        SetStartPos(in.Read<Vector2>());
+        in.Read(target_pos);
+        in.Read(pierce_count);
+        in.Read(id);
+        in.Read(enemies_hit);
+        in.Read(source);
+        current_colliding.clear();
+        unsigned int count = in.Read<unsigned int>();
+        for (unsigned int i = 0; i < count && in.ok; i++)
+        {
+            current_colliding.insert(in.Read<int>());
         }
-        position += Vector2Scale(velocity, deltaTime);
-        particles.SpawnTrail(position, velocity, getProjType());
     }
-    void Draw() override {/* empty because no need to draw anything for this class */} 
     static void LoadTextures()
     {
         BulletImage = LoadImage("assets/projectiles/smallBullet.png");
@@ -58,20 +116,11 @@ class Projectile : public Entity
         BulletTexture = LoadTextureFromImage(BulletImage);
         UnloadImage(BulletImage);
 
-        flameIMG = LoadImage("assets/projectiles/flame.png");
-        ImageResize(&flameIMG, 10, 10);
-        flameTX = LoadTextureFromImage(flameIMG);
-        UnloadImage(flameIMG);
         // laser
         LaserImage = LoadImage("assets/projectiles/laserBullet.png");
         ImageResize(&LaserImage, 40, 2);
         LaserTexture = LoadTextureFromImage(LaserImage);
         UnloadImage(LaserImage);
-
-        iceIMG = LoadImage("assets/projectiles/ice_bullet.png");
-        ImageResize(&iceIMG, 30, 30);
-        iceTexture = LoadTextureFromImage(iceIMG);
-        UnloadImage(iceIMG);
     }
     static void DestroyTextures()
     {
@@ -84,17 +133,9 @@ class Projectile : public Entity
     inline static Image BulletImage;
     inline static Texture2D BulletTexture;
 
-    inline static Image flameIMG;
-    inline static Texture2D flameTX;
     // laser bullet
     inline static Image LaserImage;
     inline static Texture2D LaserTexture;
-
-    inline static Image iceIMG;
-    inline static Texture2D iceTexture;
-
-  private:
-    static inline unsigned long long next_id;
 };
 
 class normal_bullet : public Projectile
@@ -104,18 +145,21 @@ class normal_bullet : public Projectile
     normal_bullet(Vector2 startPos, Vector2 targetPos) : Projectile(startPos, targetPos)
     {
 
-        velocity = velFromSpeed(startPos, targetPos, normal_bullet_speed); // set velocity towards target
-        radius = 3.0f;
+        SetVelocity(velFromSpeed(startPos, targetPos, normal_bullet_speed)); // set velocity towards target
+        SetRadius(3.0f);
+        bodies->range_sqr[body] = GetMaxProjRange();
         pierce_count = 1;
     }
 
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.x, velocity.y) * RAD2DEG;
         DrawTexturePro(BulletTexture, {0, 0, (float)BulletTexture.width, (float)BulletTexture.height}, {position.x, position.y, (float)BulletTexture.width, (float)BulletTexture.height}, {(float)BulletTexture.width / 2, (float)BulletTexture.height / 2}, rotation, WHITE);
     }
     ProjectileType getProjType() override { return ProjectileType::DUO_BASIC; }
-    float GetMaxProjRange() override { return 1 << 20; }
+    float GetMaxProjRange() override { return projectile_max_range_sqr; }
 };
 
 class laser_bullet : public Projectile
@@ -124,42 +168,32 @@ class laser_bullet : public Projectile
   public:
     laser_bullet(Vector2 startPos, Vector2 targetPos) : Projectile(startPos, targetPos)
     {
-        velocity = velFromSpeed(startPos, targetPos, lancer_bullet_speed);
+        SetVelocity(velFromSpeed(startPos, targetPos, lancer_bullet_speed));
         spawnTimer = m_spawnTimer;
         state = ProjectileState::SPAWNING;
-        radius = 1.5f;
+        SetRadius(1.5f);
+        bodies->range_sqr[body] = GetMaxProjRange();
+        bodies->SetFlag(body, BODY_MOVING, false); // not until it's out of the gun
         pierce_count = 2;
     }
+    // MoveProjectiles flies it once it's FLYING, the tick it gets there it still stands
     void Update(float deltaTime) override
     {
-        // delete projectile if too far from firing pos;
-        if (Vector2DistanceSqr(position, start_pos) > 1 << 20)
-        {
-            Destroy();
-            return;
-        }
-
-        switch (state)
-        {
-        case ProjectileState::SPAWNING:
+        if (state == ProjectileState::SPAWNING)
         {
             spawnTimer -= deltaTime;
             if (spawnTimer <= 0)
             {
                 state = ProjectileState::FLYING;
+                bodies->SetFlag(body, BODY_MOVING, true);
             }
-            break;
-        }
-        case ProjectileState::FLYING:
-        {
-            position += Vector2Scale(velocity, deltaTime);
-            break;
-        }
         }
     }
 
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.y, velocity.x) * RAD2DEG;
         float toRender; // how much of the texture to draw;
         if (state == ProjectileState::SPAWNING)
@@ -180,8 +214,21 @@ class laser_bullet : public Projectile
         EndBlendMode();
     }
 
+    void Save(BinaryWriter &out) override
+    {
+        Projectile::Save(out);
+        out.Write(spawnTimer);
+        out.WriteEnum(state);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Projectile::Load(in);
+        in.Read(spawnTimer);
+        state = in.ReadEnum<ProjectileState>();
+        bodies->SetFlag(body, BODY_MOVING, state == ProjectileState::FLYING);
+    }
     ProjectileType getProjType() override { return ProjectileType::LASER; }
-    float GetMaxProjRange() override { return 1 << 20; }
+    float GetMaxProjRange() override { return projectile_max_range_sqr; }
 
   private:
     // parameters of feature only for this bullet type
@@ -198,102 +245,6 @@ class laser_bullet : public Projectile
     ProjectileState state;
 };
 
-class flame_bullet : public Projectile
-{
-    // bullet for flamethrower
-  public:
-    float speed;
-    float spreadAngle = 10.0f;
-    float max_life;
-    float life;
-    flame_bullet(Vector2 startPos, Vector2 targetPos) : Projectile(startPos, targetPos)
-    {
-        // changing speed by +- 10% to sell the flame effect
-        speed = flame_bullet_speed * (1 - (GetRandomValue(-10, 10) / 100.0f));
-        // causing slight jitter in direction of travel to
-        // make it seem like an actual flamethrower
-        Vector2 dir = Vector2Normalize(targetPos - startPos);
-        float spread = GetRandomValue(-spreadAngle, spreadAngle) * DEG2RAD;
-        dir = Vector2Rotate(dir, spread);
-        velocity = Vector2Scale(dir, speed);
-        // for drawing fade
-        max_life = (ripple_turret_range / speed) * 3.0f;
-        life = max_life;
-        pierce_count = 1;
-        radius = 5.0f; // slightly bigger than projectile texture to give effect of flame
-    }
-    void Update(float deltaTime) override
-    {
-        // delete projectile if too far from firing pos;
-        if (Vector2DistanceSqr(position, start_pos) > GetMaxProjRange())
-        {
-            Destroy();
-            return;
-        }
-        life -= deltaTime;
-        position += Vector2Scale(velocity, deltaTime);
-    }
-
-    void Draw() override
-    {
-        float rotation = atan2f(velocity.x, velocity.y) * RAD2DEG;
-        float alpha = life / max_life;
-        DrawTexturePro(flameTX, {0, 0, (float)flameTX.width, (float)flameTX.height}, {position.x, position.y, (float)flameTX.width, (float)flameTX.height}, {(float)flameTX.width / 2, (float)flameTX.height / 2}, rotation, Fade(WHITE, alpha));
-    }
-    // getter functions for parent class logic that implement something
-    // based on the type/value from child classes
-    ProjectileType getProjType() override { return ProjectileType::FLAME; }
-    float GetMaxProjRange() override { return ripple_turret_range * ripple_turret_range; }
-};
-
-class ice_bullet : public Projectile
-{
-    // bullet for ice turret
-  public:
-    float speed;
-    float spreadAngle = 5.0f;
-    float max_life;
-    float life;
-    ice_bullet(Vector2 startPos, Vector2 targetPos) : Projectile(startPos, targetPos)
-    {
-        // changing speed by +- 10% to sell the flame effect
-        speed = ice_stream_speed * (1 - (GetRandomValue(-10, 10) / 100.0f));
-        // causing slight jitter in direction of travel to
-        // make it seem like an actual flamethrower
-        Vector2 dir = Vector2Normalize(targetPos - startPos);
-        float spread = GetRandomValue(-spreadAngle, spreadAngle) * DEG2RAD;
-        dir = Vector2Rotate(dir, spread);
-        velocity = Vector2Scale(dir, speed);
-        // for drawing fade
-        max_life = (salvo_turret_range / speed) * 2.0f;
-        life = max_life;
-        pierce_count = 1;
-        radius = 5.0f; // slightly bigger than projectile texture to give effect of flame
-    }
-    void Update(float deltaTime) override
-    {
-        // delete projectile if too far from firing pos;
-        if (Vector2DistanceSqr(position, start_pos) > GetMaxProjRange())
-        {
-            Destroy();
-            return;
-        }
-        life -= deltaTime;
-        position += Vector2Scale(velocity, deltaTime);
-    }
-
-    void Draw() override
-    {
-        float rotation = atan2f(velocity.x, velocity.y) * RAD2DEG;
-        float alpha = life / max_life;
-        DrawTexturePro(iceTexture, {0, 0, (float)iceTexture.width, (float)iceTexture.height}, {position.x, position.y, (float)iceTexture.width, (float)iceTexture.height}, {(float)iceTexture.width / 2, (float)iceTexture.height / 2}, rotation, Fade(WHITE, alpha));
-    }
-    // getter functions for parent class logic that implement something
-    // based on the type/value from child classes
-    ProjectileType getProjType() override { return ProjectileType::ICE_STREAM; }
-    float GetMaxProjRange() override { return salvo_turret_range * salvo_turret_range; }
-};
-
 class shotgun_bullet : public Projectile
 {
     // bullet for shotgun turret, hits many enemies
@@ -301,16 +252,19 @@ class shotgun_bullet : public Projectile
     shotgun_bullet(Vector2 startPos, Vector2 targetPos) : Projectile(startPos, targetPos)
     {
 
-        velocity = velFromSpeed(startPos, targetPos, shotgun_bullet_speed); // set velocity towards target
-        radius = 3.0f;
+        SetVelocity(velFromSpeed(startPos, targetPos, shotgun_bullet_speed)); // set velocity towards target
+        SetRadius(3.0f);
+        bodies->range_sqr[body] = GetMaxProjRange();
         pierce_count = 5;
     }
 
     void Draw() override
     {
+        Vector2 position = GetPosition();
+        Vector2 velocity = GetVelocity();
         float rotation = atan2f(velocity.x, velocity.y) * RAD2DEG;
         DrawTexturePro(BulletTexture, {0, 0, (float)BulletTexture.width, (float)BulletTexture.height}, {position.x, position.y, (float)BulletTexture.width, (float)BulletTexture.height}, {(float)BulletTexture.width / 2, (float)BulletTexture.height / 2}, rotation, WHITE);
     }
     ProjectileType getProjType() override { return ProjectileType::SMITE; }
-    float GetMaxProjRange() override { return 1 << 20; }
+    float GetMaxProjRange() override { return projectile_max_range_sqr; }
 };
@@ -0,0 +1,220 @@
+#include "Rewind.h"
+#include <cstring>
+
+void RewindBuffer::Clear()
+{
+    entries.clear();
+    dts.clear();
+    dt_base = 0;
+    bytes_used = 0;
+    since_keyframe = 0;
+}
+
+void RewindBuffer::Push(unsigned long long tick, const std::vector<unsigned char> &snapshot)
+{
+    /* same tick again (player did something, or the game was rewound right onto a snapshot), the new one wins
+     * the dts of the ticks before it already ran and stay, the replay needs them
+     */
+    if (!entries.empty() && entries.back().tick >= tick)
+    {
+        DropEntriesFrom(tick);
+        DropDtsFrom(tick);
+    }
+
+    Entry entry;
+    entry.tick = tick;
+    if (entries.empty() || since_keyframe >= keyframe_every - 1)
+    {
+        entry.keyframe = true;
+        entry.data = snapshot;
+        since_keyframe = 0;
+    }
+    else
+    {
+        entry.keyframe = false;
+        EncodeDelta(KeyframeFor(entries.size() - 1)->data, snapshot, entry.data);
+        since_keyframe++;
+    }
+    bytes_used += entry.data.size();
+    entries.push_back(std::move(entry));
+
+    /* over budget, oldest groups go first (after keyframe pushes too)
+     * the front is always a keyframe, and the newest keyframe group always stays, even if it alone is over budget:
+     * the next deltas are made against it
+     */
+    while (bytes_used > budget && KeyframeFor(entries.size() - 1) != &entries.front())
+        EvictOldest();
+}
+
+void RewindBuffer::LogTick(unsigned long long tick, float dt)
+{
+    if (dts.empty())
+        dt_base = tick;
+    // ticks are logged in order, anything else means the caller rewound without DropAfter
+    if (tick != dt_base + dts.size())
+    {
+        dts.clear();
+        dt_base = tick;
+    }
+    dts.push_back(dt);
+    // no point keeping dts from before the oldest snapshot
+    unsigned long long oldest = OldestTick();
+    while (!dts.empty() && dt_base < oldest)
+    {
+        dts.pop_front();
+        dt_base++;
+    }
+}
+
+bool RewindBuffer::Restore(unsigned long long tick, std::vector<unsigned char> &out, unsigned long long &snapshotTick) const
+{
+    for (size_t i = entries.size(); i-- > 0;)
+    {
+        const Entry &entry = entries[i];
+        if (entry.tick > tick)
+            continue;
+        snapshotTick = entry.tick;
+        if (entry.keyframe)
+        {
+            out = entry.data;
+            return true;
+        }
+        const Entry *key = KeyframeFor(i);
+        return key && DecodeDelta(key->data, entry.data, out);
+    }
+    return false;
+}
+
+float RewindBuffer::GetDt(unsigned long long tick) const
+{
+    if (tick < dt_base || tick >= dt_base + dts.size())
+        return 0.0f;
+    return dts[tick - dt_base];
+}
+
+void RewindBuffer::DropAfter(unsigned long long tick)
+{
+    // the snapshot of tick is the state before it ran, so it stays, the dt of tick doesn't
+    DropEntriesFrom(tick + 1);
+    DropDtsFrom(tick);
+}
+
+void RewindBuffer::DropEntriesFrom(unsigned long long tick)
+{
+    while (!entries.empty() && entries.back().tick >= tick)
+    {
+        bytes_used -= entries.back().data.size();
+        entries.pop_back();
+    }
+    // count deltas since the last keyframe again
+    since_keyframe = 0;
+    for (size_t i = entries.size(); i-- > 0 && !entries[i].keyframe;)
+        since_keyframe++;
+}
+
+void RewindBuffer::DropDtsFrom(unsigned long long tick)
+{
+    while (!dts.empty() && dt_base + dts.size() > tick)
+    {
+        dts.pop_back();
+    }
+}
+
+const RewindBuffer::Entry *RewindBuffer::KeyframeFor(size_t index) const
+{
+    for (size_t i = index + 1; i-- > 0;)
+    {
+        if (entries[i].keyframe)
+            return &entries[i];
+    }
+    return nullptr;
+}
+
+// drops the oldest keyframe and every delta that needs it
+void RewindBuffer::EvictOldest()
+{
+    if (entries.empty())
+        return;
+    do
+    {
+        bytes_used -= entries.front().data.size();
+        entries.pop_front();
+    } while (!entries.empty() && !entries.front().keyframe);
+}
+
+/* delta format: u32 length of the snapshot, then pairs of
+ * (u32 zero bytes to skip, u32 n, n bytes of key xor snapshot) until the snapshot is covered
+ * most of a snapshot stays the same for a few seconds (turrets, stats, waves), so the skips eat most of it
+ */
+static void PutU32(std::vector<unsigned char> &out, unsigned int v)
+{
+    unsigned char b[4];
+    std::memcpy(b, &v, 4);
+    out.insert(out.end(), b, b + 4);
+}
+static unsigned int GetU32(const std::vector<unsigned char> &in, size_t &pos, bool &ok)
+{
+    unsigned int v = 0;
+    if (pos + 4 > in.size())
+    {
+        ok = false;
+        return 0;
+    }
+    std::memcpy(&v, in.data() + pos, 4);
+    pos += 4;
+    return v;
+}
+
+void RewindBuffer::EncodeDelta(const std::vector<unsigned char> &key, const std::vector<unsigned char> &snapshot, std::vector<unsigned char> &out)
+{
+    out.clear();
+    PutU32(out, (unsigned int)snapshot.size());
+    size_t n = snapshot.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        size_t zeros = 0;
+        while (i + zeros < n && snapshot[i + zeros] == (i + zeros < key.size() ? key[i + zeros] : 0))
+            zeros++;
+        i += zeros;
+        // literal run ends at the first stretch of 8 equal bytes, shorter gaps aren't worth a new pair
+        size_t start = i;
+        size_t same = 0;
+        while (i < n && same < 8)
+        {
+            unsigned char k = i < key.size() ? key[i] : 0;
+            same = snapshot[i] == k ? same + 1 : 0;
+            i++;
+        }
+        if (same == 8)
+            i -= 8;
+        PutU32(out, (unsigned int)zeros);
+        PutU32(out, (unsigned int)(i - start));
+        for (size_t j = start; j < i; j++)
+            out.push_back(snapshot[j] ^ (j < key.size() ? key[j] : 0));
+    }
+    out.shrink_to_fit();
+}
+
+bool RewindBuffer::DecodeDelta(const std::vector<unsigned char> &key, const std::vector<unsigned char> &delta, std::vector<unsigned char> &out)
+{
+    bool ok = true;
+    size_t pos = 0;
+    size_t n = GetU32(delta, pos, ok);
+    if (!ok)
+        return false;
+    out.resize(n);
+    size_t i = 0;
+    while (i < n && ok)
+    {
+        size_t zeros = GetU32(delta, pos, ok);
+        size_t literal = GetU32(delta, pos, ok);
+        if (!ok || i + zeros + literal > n || pos + literal > delta.size())
+            return false;
+        for (size_t j = 0; j < zeros; j++, i++)
+            out[i] = i < key.size() ? key[i] : 0;
+        for (size_t j = 0; j < literal; j++, i++)
+            out[i] = delta[pos++] ^ (i < key.size() ? key[i] : 0);
+    }
+    return ok && i == n;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+/* Ring of game state snapshots for rewinding
+ * Push() a snapshot (from SaveSnapshot) every few ticks, every keyframe_every-th one is stored whole,
+ * the ones in between only as the difference to their keyframe (xor, then runs of zeros squeezed out).
+ * When the stored bytes go over the budget the oldest keyframe and its deltas get dropped.
+ * The dt of every tick is logged too, so a tick between two snapshots can be reached
+ * by loading the one before it and simulating forward with the same dts.
+ * Player actions (build, sell, upgrade, next wave) force a snapshot, so nothing between two snapshots
+ * depends on input and re-simulating gives the same result.
+ */
+class RewindBuffer
+{
+  public:
+    RewindBuffer(size_t budgetBytes, int snapshotInterval, int keyframeEvery)
+        : budget(budgetBytes), interval(snapshotInterval), keyframe_every(keyframeEvery) {}
+
+    void Clear();
+    // a snapshot is due for this tick (every interval ticks)
+    bool IsDue(unsigned long long tick) const { return tick % interval == 0; }
+    // first tick after this one that is due
+    unsigned long long NextDue(unsigned long long tick) const { return (tick / interval + 1) * interval; }
+    // state before simulating tick, replaces one already stored for the same tick
+    void Push(unsigned long long tick, const std::vector<unsigned char> &snapshot);
+    // dt used to simulate tick, call once per tick in order
+    void LogTick(unsigned long long tick, float dt);
+
+    // latest snapshot at or before tick, rebuilt into out, returns its tick or false if none
+    bool Restore(unsigned long long tick, std::vector<unsigned char> &out, unsigned long long &snapshotTick) const;
+    float GetDt(unsigned long long tick) const;
+    // forget everything after tick, used when the past gets changed
+    void DropAfter(unsigned long long tick);
+
+    bool Empty() const { return entries.empty(); }
+    unsigned long long OldestTick() const { return entries.empty() ? 0 : entries.front().tick; }
+    size_t BytesUsed() const { return bytes_used; }
+    size_t Budget() const { return budget; }
+    size_t Count() const { return entries.size(); }
+
+  private:
+    struct Entry
+    {
+        unsigned long long tick;
+        bool keyframe;
+        std::vector<unsigned char> data; // whole snapshot for keyframes, encoded delta otherwise
+    };
+    std::deque<Entry> entries;
+    std::deque<float> dts; // dts[i] is the dt of tick dt_base + i
+    unsigned long long dt_base = 0;
+    size_t bytes_used = 0;
+    size_t budget;
+    int interval;
+    int keyframe_every;
+    int since_keyframe = 0;
+    std::vector<unsigned char> scratch;
+
+    const Entry *KeyframeFor(size_t index) const;
+    // snapshots of tick and later / dts of tick and later
+    void DropEntriesFrom(unsigned long long tick);
+    void DropDtsFrom(unsigned long long tick);
+    void EvictOldest();
+    static void EncodeDelta(const std::vector<unsigned char> &key, const std::vector<unsigned char> &snapshot, std::vector<unsigned char> &out);
+    static bool DecodeDelta(const std::vector<unsigned char> &key, const std::vector<unsigned char> &delta, std::vector<unsigned char> &out);
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/* Tiny binary writer/reader for snapshots
+ * Values are copied as raw bytes (little-endian, whatever the machine uses, it's only ever read back by the same build),
+ * bools and enums go in as one byte each to keep the blob small.
+ * The reader never reads past the end: once something is missing ok turns false and everything after reads as zero.
+ */
+class BinaryWriter
+{
+  public:
+    std::vector<unsigned char> data;
+
+    template <typename T>
+    void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a snapshot");
+        size_t at = data.size();
+        data.resize(at + sizeof(T));
+        std::memcpy(data.data() + at, &value, sizeof(T));
+    }
+    void WriteBool(bool value) { Write<unsigned char>(value ? 1 : 0); }
+    template <typename E>
+    void WriteEnum(E value) { Write<unsigned char>((unsigned char)value); }
+    void WriteBytes(const void *bytes, size_t count)
+    {
+        size_t at = data.size();
+        data.resize(at + count);
+        std::memcpy(data.data() + at, bytes, count);
+    }
+    void clear() { data.clear(); }
+};
+
+class BinaryReader
+{
+  public:
+    BinaryReader(const unsigned char *bytes, size_t count) : data(bytes), size(count) {}
+    explicit BinaryReader(const std::vector<unsigned char> &bytes) : data(bytes.data()), size(bytes.size()) {}
+
+    bool ok = true;
+
+    template <typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values come out of a snapshot");
+        T value{};
+        if (!ok || pos + sizeof(T) > size)
+        {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+    // reads straight into value, works for plain arrays too
+    template <typename T>
+    void Read(T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values come out of a snapshot");
+        ReadBytes(&value, sizeof(T));
+    }
+    bool ReadBool() { return Read<unsigned char>() != 0; }
+    template <typename E>
+    E ReadEnum() { return (E)Read<unsigned char>(); }
+    void ReadBytes(void *bytes, size_t count)
+    {
+        if (!ok || pos + count > size)
+        {
+            ok = false;
+            std::memset(bytes, 0, count);
+            return;
+        }
+        std::memcpy(bytes, data + pos, count);
+        pos += count;
+    }
+    bool AtEnd() const { return pos == size; }
+    size_t Remaining() const { return size - pos; }
+
+  private:
+    const unsigned char *data;
+    size_t size;
+    size_t pos = 0;
+};
@@ -0,0 +1,247 @@
+#include "Snapshot.h"
+#include "Config.h"
+#include "Enemy.h"
+#include "Projectile.h"
+#include "Turret.h"
+#include <fstream>
+#include <iterator>
+
+// ---- making an empty entity of the right class, Load() fills in the rest ----
+static std::unique_ptr<Entity> MakeEnemy(EnemyType type)
+{
+    switch (type)
+    {
+    case EnemyType::FLARE:
+        return std::make_unique<flare_enemy>();
+    case EnemyType::MONO:
+        return std::make_unique<mono_enemy>();
+    case EnemyType::CRAWLER:
+        return std::make_unique<crawler_enemy>();
+    case EnemyType::POLY:
+        return std::make_unique<poly_enemy>();
+    case EnemyType::LOCUS:
+        return std::make_unique<locus_enemy>();
+    case EnemyType::ANTUMBRA:
+        return std::make_unique<antumbra_enemy>();
+    }
+    return nullptr;
+}
+
+static std::unique_ptr<Entity> MakeProjectile(ProjectileType type)
+{
+    Vector2 from = {0, 0}, to = {1, 0};
+    switch (type)
+    {
+    case ProjectileType::DUO_BASIC:
+        return std::make_unique<normal_bullet>(from, to);
+    case ProjectileType::LASER:
+        return std::make_unique<laser_bullet>(from, to);
+    case ProjectileType::SMITE:
+        return std::make_unique<shotgun_bullet>(from, to);
+    default:
+        return nullptr; // beams and streams aren't projectile entities
+    }
+}
+
+void SaveSnapshot(BinaryWriter &out, GameState &state)
+{
+    state.MakeCurrent();
+    std::vector<std::unique_ptr<Entity>> &entities = state.entities;
+    out.Write(SNAPSHOT_MAGIC);
+    out.Write(SNAPSHOT_VERSION);
+
+    out.Write(state.player_health);
+    out.Write(state.playerMoney);
+    out.Write(state.enemy_health_multiplier);
+    out.Write(state.enemies_killed);
+    out.Write(state.next_enemy_id);
+    out.Write(state.next_projectile_id);
+    out.Write(state.next_enemy_path);
+    out.WriteEnum(state.nav_mode);
+
+    state.wave_manager.Save(out);
+    state.stat_manager.Save(out);
+    state.map.SaveTiles(out);
+
+    unsigned int count = 0;
+    for (auto &entity : entities)
+    {
+        if (entity->IsActive())
+            count++;
+    }
+    out.Write(count);
+    for (auto &entity : entities)
+    {
+        if (!entity->IsActive())
+            continue; // about to be erased anyway
+        out.WriteEnum(entity->kind);
+        switch (entity->kind)
+        {
+        case EntityKind::TURRET:
+            out.WriteEnum(static_cast<Turret *>(entity.get())->turret);
+            break;
+        case EntityKind::ENEMY:
+            out.WriteEnum(static_cast<Enemy *>(entity.get())->GetEnemyType());
+            break;
+        case EntityKind::PROJECTILE:
+            out.WriteEnum(static_cast<Projectile *>(entity.get())->getProjType());
+            break;
+        }
+        entity->Save(out);
+    }
+}
+
+/* the Enemy / Projectile constructors take an id and a spawn from the game's counters,
+ * building the loaded ones would move them on even when the load fails halfway,
+ * so they're put back on the way out unless the load went through (which sets them from the snapshot)
+ */
+struct CounterGuard
+{
+    GameState &state;
+    unsigned long long enemy_id = state.next_enemy_id;
+    int enemy_path = state.next_enemy_path;
+    unsigned long long projectile_id = state.next_projectile_id;
+    bool keep = false;
+    ~CounterGuard()
+    {
+        if (keep)
+            return;
+        state.next_enemy_id = enemy_id;
+        state.next_enemy_path = enemy_path;
+        state.next_projectile_id = projectile_id;
+    }
+};
+
+bool LoadSnapshot(BinaryReader &in, GameState &state)
+{
+    state.MakeCurrent();
+    CounterGuard counters{state};
+    Map &map = state.map;
+    if (in.Read<unsigned int>() != SNAPSHOT_MAGIC || in.Read<unsigned short>() != SNAPSHOT_VERSION || !in.ok)
+        return false;
+
+    int health = in.Read<int>();
+    int money = in.Read<int>();
+    float multiplier = in.Read<float>();
+    int killed = in.Read<int>();
+    unsigned long long enemy_next_id = in.Read<unsigned long long>();
+    unsigned long long projectile_next_id = in.Read<unsigned long long>();
+    int next_path = in.Read<int>();
+    NavMode saved_nav_mode = in.ReadEnum<NavMode>();
+
+    WaveManager loaded_waves = state.wave_manager;
+    loaded_waves.Load(in);
+    StatsManager loaded_stats;
+    loaded_stats.Load(in);
+    std::vector<bool> occupied;
+    std::vector<TileType> types;
+    if (!map.LoadTiles(in, occupied, types))
+        return false;
+    /* the saved enemies walk the paths of the saved tiles, not the current ones if the map was edited since,
+     * and the current ones are out of date anyway while the flow field is on (edits don't rebuild them)
+     */
+    bool edited = false;
+    for (size_t i = 0; i < types.size() && !edited; i++)
+        edited = map.tiles[i].GetType() != types[i];
+    std::vector<EnemyPath> paths;
+    if ((edited || saved_nav_mode == NavMode::WAYPOINTS) && !map.PathsFor(types, paths))
+        return false;
+
+    unsigned int count = in.Read<unsigned int>();
+    std::vector<std::unique_ptr<Entity>> loaded;
+    loaded.reserve(count < in.Remaining() ? count : in.Remaining());
+    for (unsigned int i = 0; i < count && in.ok; i++)
+    {
+        EntityKind kind = in.ReadEnum<EntityKind>();
+        unsigned char subtype = in.Read<unsigned char>();
+        std::unique_ptr<Entity> entity;
+        switch (kind)
+        {
+        case EntityKind::TURRET:
+            // real position and tile get set after Load()
+            entity = subtype < TURRET_TYPE_COUNT ? Turret::Make((TurretType)subtype, {0, 0}, nullptr) : nullptr;
+            break;
+        case EntityKind::ENEMY:
+            entity = subtype < ENEMY_TYPE_COUNT ? MakeEnemy((EnemyType)subtype) : nullptr;
+            break;
+        case EntityKind::PROJECTILE:
+            entity = MakeProjectile((ProjectileType)subtype);
+            break;
+        }
+        if (!entity)
+            return false;
+        entity->Load(in);
+        if (kind == EntityKind::ENEMY)
+        {
+            // saved on a map with other paths, nowhere to walk (the flow field works from anywhere)
+            Enemy *enemy = static_cast<Enemy *>(entity.get());
+            if (saved_nav_mode == NavMode::WAYPOINTS && (enemy->path_index < 0 || enemy->path_index >= (int)paths.size() || enemy->map_counter >= (int)paths[enemy->path_index].waypoints.size()))
+                return false;
+        }
+        if (kind == EntityKind::TURRET)
+        {
+            Tile *tile = map.getTileFromMouse(entity->GetPosition());
+            if (!tile)
+                return false;
+            static_cast<Turret *>(entity.get())->tileOfTurret = tile;
+        }
+        loaded.push_back(std::move(entity));
+    }
+    if (!in.ok)
+        return false;
+
+    // everything read fine, swap it all in, the tiles first: the only part that can still say no
+    if (!map.ApplyTiles(occupied, types))
+        return false;
+    counters.keep = true;
+    state.entities.swap(loaded);
+    state.parkedCount = 0; // the loaded enemies aren't parked
+    state.player_health = health;
+    state.playerMoney = money;
+    state.enemy_health_multiplier = multiplier;
+    state.enemies_killed = killed;
+    state.next_enemy_id = enemy_next_id;
+    state.next_projectile_id = projectile_next_id;
+    state.next_enemy_path = next_path;
+    // ApplyTiles only rebuilt them if the tiles changed
+    if (saved_nav_mode == NavMode::WAYPOINTS && state.nav_mode != NavMode::WAYPOINTS && !edited)
+        map.BuildWaypoints();
+    state.nav_mode = saved_nav_mode;
+    state.wave_manager = loaded_waves;
+    state.stat_manager = loaded_stats;
+    // the tile -> turret handles went with the old entities, hand out new ones
+    for (auto &entity : state.entities)
+    {
+        if (entity->kind == EntityKind::TURRET)
+        {
+            Turret *turret = static_cast<Turret *>(entity.get());
+            map.PlaceTurret(turret->tileOfTurret, turret);
+        }
+    }
+    // hits from before don't belong to the loaded state
+    state.damage_events.clear();
+    state.particles.cleanup();
+    return true;
+}
+
+bool SaveSnapshotFile(const char *path, GameState &state)
+{
+    BinaryWriter out;
+    SaveSnapshot(out, state);
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    file.write((const char *)out.data.data(), out.data.size());
+    return (bool)file;
+}
+
+bool LoadSnapshotFile(const char *path, GameState &state)
+{
+    state.MakeCurrent();
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BinaryReader in(bytes);
+    return LoadSnapshot(in, state);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "GameState.h"
+#include "Serialize.h"
+
+/* Whole game state as one binary blob
+ * Layout: magic "OZSN", version, globals (health, money, multiplier, kills, id counters),
+ * wave progress, stats, tile occupancy, then every live entity as (kind, subtype, fields).
+ * Particles, health bars and the camera are left out, they're only what's on screen.
+ * Loading builds everything on the side first and only swaps it in if the whole blob read fine.
+ * Bump SNAPSHOT_VERSION whenever any Save() changes what it writes.
+ * All four work on state, and leave it as the game this thread is on.
+ */
+const unsigned int SNAPSHOT_MAGIC = 0x4E535A4F; // "OZSN" in the file
+const unsigned short SNAPSHOT_VERSION = 3; // 2: enemies remember which path they are on, 3: nav mode and tile types
+
+void SaveSnapshot(BinaryWriter &out, GameState &state);
+bool LoadSnapshot(BinaryReader &in, GameState &state);
+
+bool SaveSnapshotFile(const char *path, GameState &state);
+bool LoadSnapshotFile(const char *path, GameState &state);
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/* Fixed size ring for exactly one producer thread and one consumer thread, no locks.
+ * Push() never waits: when the ring is full it says so and the caller decides (telemetry drops the event).
+ * head is only written by the producer, tail only by the consumer, each on its own cache line,
+ * and each side keeps a stale copy of the other's index so it only reads the shared one when it looks full / empty.
+ */
+template <typename T>
+class SpscQueue
+{
+  public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // producer only
+    bool Push(const T &value)
+    {
+        size_t at = head.load(std::memory_order_relaxed);
+        if (at - tailSeen > mask)
+        {
+            tailSeen = tail.load(std::memory_order_acquire);
+            if (at - tailSeen > mask)
+                return false;
+        }
+        slots[at & mask] = value;
+        head.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, up to max values into out, returns how many
+    size_t PopMany(T *out, size_t max)
+    {
+        size_t at = tail.load(std::memory_order_relaxed);
+        if (headSeen == at)
+            headSeen = head.load(std::memory_order_acquire);
+        size_t count = headSeen - at;
+        if (count > max)
+            count = max;
+        for (size_t i = 0; i < count; i++)
+            out[i] = slots[(at + i) & mask];
+        tail.store(at + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t Capacity() const { return mask + 1; }
+
+  private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0}; // next slot the producer fills
+    size_t tailSeen = 0;                     // producer's copy of tail
+    alignas(64) std::atomic<size_t> tail{0}; // next slot the consumer reads
+    size_t headSeen = 0;                     // consumer's copy of head
+};
@@ -1,31 +1,82 @@
 #pragma once
 
+#include "Serialize.h"
 #include "Types.h"
-#include <map>
-using namespace std; 
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
 
 /* class that handles information about player work
  * total damage, kill by type and money spent
- * should've added time played also but meh
+ * per turret (type and each placed instance) damage, kills and overkill
+ * and a per-wave dps history
+ * everything is a plain array indexed by enum / slot, so an update is a few additions
  */
 
+// one placed turret. Upgrading creates a new record, since the upgraded turret is a new entity
+struct TurretRecord
+{
+    TurretType type;
+    int cost = 0;
+    double damage = 0;
+    int kills = 0;
+    double overkill = 0; // damage that went into already dead enemies (the killing blow's excess)
+    bool alive = true;
+};
+
+// one finished wave
+struct WaveSample
+{
+    int wave = 0;
+    double damage = 0;
+    float duration = 0;
+    float GetDPS() const { return duration > 0 ? (float)(damage / duration) : 0.0f; }
+};
+
 class StatsManager
 {
   public:
-    map<EnemyType, int> enemies_killed_by_type;
+    int enemies_killed_by_type[ENEMY_TYPE_COUNT] = {};
     int total_money_spent = 0;
-    unsigned long long total_damage_done = 0;
+    double total_damage_done = 0;
+
+    // per turret type
+    double damage_by_turret[TURRET_TYPE_COUNT] = {};
+    int kills_by_turret[TURRET_TYPE_COUNT] = {};
+    double overkill_by_turret[TURRET_TYPE_COUNT] = {};
+    int money_by_turret[TURRET_TYPE_COUNT] = {};
+
+    // per turret instance, indexed by Turret::stats_slot
+    vector<TurretRecord> turrets;
+
+    // ring buffer of the last WAVE_HISTORY waves, oldest gets overwritten
+    static const int WAVE_HISTORY = 64;
+    WaveSample wave_history[WAVE_HISTORY];
+    int wave_history_head = 0;  // where the next sample goes
+    int wave_history_count = 0; // how many are valid
+
     StatsManager() {}
     void reset()
     {
-        enemies_killed_by_type.clear();
-        total_money_spent = 0;
-        total_damage_done = 0;
+        *this = StatsManager();
     }
 
     void EnemyKilled(EnemyType type)
     {
-        enemies_killed_by_type[type]++;
+        enemies_killed_by_type[(int)type]++;
+    }
+    // kill credited to whoever landed the last hit
+    void EnemyKilled(EnemyType type, int source, double overkill)
+    {
+        EnemyKilled(type);
+        if (source < 0)
+            return;
+        TurretRecord &t = turrets[source];
+        t.kills++;
+        t.overkill += overkill;
+        kills_by_turret[(int)t.type]++;
+        overkill_by_turret[(int)t.type] += overkill;
     }
 
     void MoneySpent(int amount)
@@ -33,10 +84,212 @@ class StatsManager
         total_money_spent += amount;
     }
 
+    // registers a freshly built (or upgraded) turret, returns its slot for attribution
+    int TurretBuilt(TurretType type, int cost)
+    {
+        MoneySpent(cost);
+        money_by_turret[(int)type] += cost;
+        TurretRecord record;
+        record.type = type;
+        record.cost = cost;
+        turrets.push_back(record);
+        return (int)turrets.size() - 1;
+    }
+    void TurretRemoved(int slot)
+    {
+        if (slot >= 0)
+            turrets[slot].alive = false;
+    }
+
+    // damage from one hit, source is a turret slot or -1 if nobody in particular
+    void HitDealt(int source, float amount)
+    {
+        if (source < 0)
+            return;
+        TurretRecord &t = turrets[source];
+        t.damage += amount;
+        damage_by_turret[(int)t.type] += amount;
+    }
+    // the whole tick's damage, in one call
     void DamageDealt(float amount)
     {
         total_damage_done += amount;
+        if (wave_running)
+            wave_damage += amount;
+    }
+
+    // ---- wave timeline ----
+    void WaveStarted(int wave)
+    {
+        wave_running = true;
+        current_wave = wave;
+        wave_damage = 0;
+        wave_time = 0;
+    }
+    void Tick(float deltaTime)
+    {
+        if (wave_running)
+            wave_time += deltaTime;
+    }
+    void WaveEnded()
+    {
+        if (!wave_running)
+            return;
+        wave_running = false;
+        WaveSample &sample = wave_history[wave_history_head];
+        sample.wave = current_wave;
+        sample.damage = wave_damage;
+        sample.duration = wave_time;
+        wave_history_head = (wave_history_head + 1) % WAVE_HISTORY;
+        if (wave_history_count < WAVE_HISTORY)
+            wave_history_count++;
+    }
+    // i-th sample, oldest first
+    const WaveSample &GetWaveSample(int i) const
+    {
+        int start = (wave_history_head - wave_history_count + WAVE_HISTORY) % WAVE_HISTORY;
+        return wave_history[(start + i) % WAVE_HISTORY];
+    }
+
+    double DamagePerCost(TurretType type) const
+    {
+        int spent = money_by_turret[(int)type];
+        return spent > 0 ? damage_by_turret[(int)type] / spent : 0.0;
+    }
+
+    static const char *EnemyName(EnemyType type)
+    {
+        static const char *names[ENEMY_TYPE_COUNT] = {"Flare", "Mono", "Crawler", "Poly", "Locus", "Antumbra"};
+        return names[(int)type];
+    }
+    static const char *TurretName(TurretType type)
+    {
+        static const char *names[TURRET_TYPE_COUNT] = {"Duo", "Ripple", "Smite", "Lancer", "Cyclone", "Meltdown", "Wave", "Salvo"};
+        return names[(int)type];
+    }
+
+    // ---- export, called once at game end ----
+    // CSV is a few small tables one after another, each with its own header line
+    bool ExportCSV(const string &path) const
+    {
+        ofstream out(path);
+        if (!out)
+            return false;
+        out << "total_damage,total_money_spent\n";
+        out << total_damage_done << "," << total_money_spent << "\n\n";
+
+        out << "enemy,kills\n";
+        for (int i = 0; i < ENEMY_TYPE_COUNT; i++)
+            out << EnemyName((EnemyType)i) << "," << enemies_killed_by_type[i] << "\n";
+
+        out << "\nturret_type,damage,kills,overkill,money_spent,damage_per_cost\n";
+        for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+            out << TurretName((TurretType)i) << "," << damage_by_turret[i] << "," << kills_by_turret[i] << "," << overkill_by_turret[i] << "," << money_by_turret[i] << "," << DamagePerCost((TurretType)i) << "\n";
+
+        out << "\nturret_slot,type,cost,damage,kills,overkill,alive\n";
+        for (size_t i = 0; i < turrets.size(); i++)
+        {
+            const TurretRecord &t = turrets[i];
+            out << i << "," << TurretName(t.type) << "," << t.cost << "," << t.damage << "," << t.kills << "," << t.overkill << "," << (t.alive ? 1 : 0) << "\n";
+        }
+
+        out << "\nwave,damage,duration,dps\n";
+        for (int i = 0; i < wave_history_count; i++)
+        {
+            const WaveSample &w = GetWaveSample(i);
+            out << w.wave << "," << w.damage << "," << w.duration << "," << w.GetDPS() << "\n";
+        }
+        return true;
+    }
+
+    bool ExportJSON(const string &path) const
+    {
+        ofstream out(path);
+        if (!out)
+            return false;
+        out << "{\n  \"total_damage\": " << total_damage_done << ",\n  \"total_money_spent\": " << total_money_spent << ",\n";
+
+        out << "  \"kills_by_enemy\": {";
+        for (int i = 0; i < ENEMY_TYPE_COUNT; i++)
+            out << (i ? ", " : "") << "\"" << EnemyName((EnemyType)i) << "\": " << enemies_killed_by_type[i];
+        out << "},\n";
+
+        out << "  \"turret_types\": [\n";
+        for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+        {
+            out << "    {\"type\": \"" << TurretName((TurretType)i) << "\", \"damage\": " << damage_by_turret[i] << ", \"kills\": " << kills_by_turret[i] << ", \"overkill\": " << overkill_by_turret[i]
+                << ", \"money_spent\": " << money_by_turret[i] << ", \"damage_per_cost\": " << DamagePerCost((TurretType)i) << "}" << (i + 1 < TURRET_TYPE_COUNT ? "," : "") << "\n";
+        }
+        out << "  ],\n";
+
+        out << "  \"turrets\": [\n";
+        for (size_t i = 0; i < turrets.size(); i++)
+        {
+            const TurretRecord &t = turrets[i];
+            out << "    {\"slot\": " << i << ", \"type\": \"" << TurretName(t.type) << "\", \"cost\": " << t.cost << ", \"damage\": " << t.damage << ", \"kills\": " << t.kills << ", \"overkill\": " << t.overkill
+                << ", \"alive\": " << (t.alive ? "true" : "false") << "}" << (i + 1 < turrets.size() ? "," : "") << "\n";
+        }
+        out << "  ],\n";
+
+        out << "  \"waves\": [\n";
+        for (int i = 0; i < wave_history_count; i++)
+        {
+            const WaveSample &w = GetWaveSample(i);
+            out << "    {\"wave\": " << w.wave << ", \"damage\": " << w.damage << ", \"duration\": " << w.duration << ", \"dps\": " << w.GetDPS() << "}" << (i + 1 < wave_history_count ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return true;
+    }
+
+    // ---- snapshots ----
+    void Save(BinaryWriter &out) const
+    {
+        out.Write(enemies_killed_by_type);
+        out.Write(total_money_spent);
+        out.Write(total_damage_done);
+        out.Write(damage_by_turret);
+        out.Write(kills_by_turret);
+        out.Write(overkill_by_turret);
+        out.Write(money_by_turret);
+        out.Write((unsigned int)turrets.size());
+        out.WriteBytes(turrets.data(), turrets.size() * sizeof(TurretRecord));
+        out.Write(wave_history);
+        out.Write(wave_history_head);
+        out.Write(wave_history_count);
+        out.WriteBool(wave_running);
+        out.Write(current_wave);
+        out.Write(wave_damage);
+        out.Write(wave_time);
+    }
+    void Load(BinaryReader &in)
+    {
+        in.Read(enemies_killed_by_type);
+        in.Read(total_money_spent);
+        in.Read(total_damage_done);
+        in.Read(damage_by_turret);
+        in.Read(kills_by_turret);
+        in.Read(overkill_by_turret);
+        in.Read(money_by_turret);
+        unsigned int turret_count = in.Read<unsigned int>();
+        if (turret_count * sizeof(TurretRecord) > in.Remaining())
+        {
+            in.ok = false; // count doesn't fit in what's left, broken blob
+            return;
+        }
+        turrets.resize(turret_count);
+        in.ReadBytes(turrets.data(), turrets.size() * sizeof(TurretRecord));
+        in.Read(wave_history);
+        in.Read(wave_history_head);
+        in.Read(wave_history_count);
+        wave_running = in.ReadBool();
+        in.Read(current_wave);
+        in.Read(wave_damage);
+        in.Read(wave_time);
     }
 
-    
-};
\ No newline at end of file
+  private:
+    bool wave_running = false;
+    int current_wave = 0;
+    double wave_damage = 0;
+    float wave_time = 0;
+};
@@ -0,0 +1,199 @@
+#include "Systems.h"
+#include "Config.h"
+#include "Enemy.h"
+#include "GameState.h"
+#include "Projectile.h"
+#include "raymath.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+using namespace std;
+
+void MoveEnemy(BodyTable &enemies, size_t i, const Rectangle &bounds, float dt)
+{
+    float x = enemies.x[i];
+    float y = enemies.y[i];
+    enemies.last_x[i] = x;
+    enemies.last_y[i] = y;
+    // a tile of slack around the map, exits on the border lead one tile out of it
+    if (x < bounds.x - TILE_SIZE * 2 || y < bounds.y - TILE_SIZE * 2 || x > bounds.x + bounds.width + TILE_SIZE * 2 || y > bounds.y + bounds.height + TILE_SIZE * 2 || y == NAN || x == NAN)
+    {
+        // if enemy goes off screen for some reason, just delete it
+        // the NAN check exists only to catch whenever a variable remains uninitialised and crashes the whole thing
+        // Happened a few times and debugging was a nightmare
+        // Realised I can't guarantee existence especially when rolling out new features.
+        enemies.owner[i]->Destroy();
+    }
+    enemies.x[i] = x + enemies.vel_x[i] * dt;
+    enemies.y[i] = y + enemies.vel_y[i] * dt;
+}
+
+void MoveEnemies(BodyTable &enemies, const Rectangle &bounds, float dt)
+{
+    enemies.Compact();
+    const size_t n = enemies.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        if ((enemies.flags[i] & (BODY_ACTIVE | BODY_PARKED)) == BODY_ACTIVE)
+            MoveEnemy(enemies, i, bounds, dt);
+    }
+}
+
+void MoveProjectiles(BodyTable &projectiles, float dt)
+{
+    projectiles.Compact();
+    const size_t n = projectiles.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!(projectiles.flags[i] & BODY_ACTIVE))
+            continue;
+        float x = projectiles.x[i];
+        float y = projectiles.y[i];
+        projectiles.last_x[i] = x;
+        projectiles.last_y[i] = y;
+        // delete projectile if too far from firing pos;
+        float dx = x - projectiles.start_x[i];
+        float dy = y - projectiles.start_y[i];
+        if (dx * dx + dy * dy > projectiles.range_sqr[i])
+        {
+            projectiles.owner[i]->Destroy();
+            continue;
+        }
+        if (projectiles.flags[i] & BODY_MOVING)
+        {
+            projectiles.x[i] = x + projectiles.vel_x[i] * dt;
+            projectiles.y[i] = y + projectiles.vel_y[i] * dt;
+        }
+    }
+}
+
+/* when in the tick (0..1) a projectile going from -> to first touches enemy row i, -1 if it never does
+ * both are taken to move in a straight line over the tick, so it's one circle against a segment in the enemy's frame
+ * touching at the end is the plain CheckCollisionCircles test, so nothing that used to hit stops hitting
+ */
+static float SweptContact(const BodyTable &enemies, size_t i, Vector2 from, Vector2 to, float r)
+{
+    float walked_x = enemies.x[i] - enemies.last_x[i];
+    float walked_y = enemies.y[i] - enemies.last_y[i];
+    // from, relative to where the enemy was at the start of the tick, and the relative motion
+    float sx = from.x - enemies.last_x[i];
+    float sy = from.y - enemies.last_y[i];
+    float dx = (to.x - from.x) - walked_x;
+    float dy = (to.y - from.y) - walked_y;
+    float rr = enemies.radius[i] + r;
+    float c = sx * sx + sy * sy - rr * rr;
+    if (c <= 0.0f)
+        return 0.0f;
+    float a = dx * dx + dy * dy;
+    float b = sx * dx + sy * dy; // half of the usual b
+    float disc = b * b - a * c;
+    if (a > 0.0f && b < 0.0f && disc >= 0.0f)
+    {
+        float t = (-b - sqrtf(disc)) / a;
+        if (t <= 1.0f)
+            return t;
+    }
+    // not moving, moving apart, or float trouble right at the end, the end test decides
+    float ex = enemies.x[i] - to.x;
+    float ey = enemies.y[i] - to.y;
+    return ex * ex + ey * ey <= rr * rr ? 1.0f : -1.0f;
+}
+
+/* swept: each projectile is checked along the whole way it flew this tick, against each enemy's walk over the same tick,
+ * so a lancer bullet covering 50 px a tick at 20 Hz can't skip over a 6 px mono in between.
+ * Everything it touched on the way is hit in the order it got there, so pierce runs out on the nearest ones first
+ */
+void CollideProjectiles(BodyTable &projectiles, const BodyTable &enemies)
+{
+    FrameVector<pair<float, int>> hits(&frame_arena);
+    FrameVector<int> colliding(&frame_arena);
+    const size_t projectileCount = projectiles.size();
+    const size_t enemyCount = enemies.size();
+
+    /* no enemy gets further than reach from where it started the tick, so one whose start is further than that
+     * from the projectile's box can't touch it, and two compares on last_x / last_y say so before the swept math.
+     * The extra pixel is for float rounding, anything it lets through still goes through SweptContact
+     */
+    float reach = 0.0f;
+    for (size_t i = 0; i < enemyCount; i++)
+    {
+        if (!(enemies.flags[i] & BODY_IN_PLAY))
+            continue;
+        float walked = fabsf(enemies.x[i] - enemies.last_x[i]) + fabsf(enemies.y[i] - enemies.last_y[i]);
+        reach = fmaxf(reach, walked + enemies.radius[i]);
+    }
+    reach += 1.0f;
+
+    for (size_t p = 0; p < projectileCount; p++)
+    {
+        // checking each projectile with each enemy is still O(P*E), but over flat arrays now
+        if ((projectiles.flags[p] & (BODY_IN_PLAY | BODY_ACTIVE)) != (BODY_IN_PLAY | BODY_ACTIVE))
+            continue;
+        Projectile *projectile = static_cast<Projectile *>(projectiles.owner[p]);
+        Vector2 projFrom = projectiles.LastPosition(p);
+        Vector2 projPos = projectiles.Position(p);
+        float projRadius = projectiles.radius[p];
+        float pad = projRadius + reach;
+        float minX = fminf(projFrom.x, projPos.x) - pad;
+        float maxX = fmaxf(projFrom.x, projPos.x) + pad;
+        float minY = fminf(projFrom.y, projPos.y) - pad;
+        float maxY = fmaxf(projFrom.y, projPos.y) + pad;
+        // the few enemies it's still inside of, so the ones it's not touching don't each need a hash lookup
+        colliding.assign(projectile->current_colliding.begin(), projectile->current_colliding.end());
+        hits.clear();
+        // the columns it goes down, as plain pointers, so the compiler doesn't reload them after every push_back
+        const unsigned char *flags = enemies.flags.data();
+        const float *startX = enemies.last_x.data();
+        const float *startY = enemies.last_y.data();
+        for (size_t i = 0; i < enemyCount; i++)
+        {
+            if (!(flags[i] & BODY_IN_PLAY))
+                continue;
+            /* for collision checking
+             * we are basically checking if this projectile
+             * has the enemy_id in it's "currently colliding" stack,
+             * So as to prevent cases where collisions are detected each frame,
+             * before the projectile has had a chance to leave the hitbox of
+             * enemy.
+             * If they are colliding => check if they have already collided
+             * else => remove from current_colliding stack;
+             */
+            float ex = startX[i];
+            float ey = startY[i];
+            // & and not &&, almost nobody is nearby and four short-circuit branches on random positions mispredict a lot
+            bool nearby = (ex >= minX) & (ex <= maxX) & (ey >= minY) & (ey <= maxY);
+            float t = nearby ? SweptContact(enemies, i, projFrom, projPos, projRadius) : -1.0f;
+            if (t >= 0.0f)
+            {
+                hits.push_back({t, (int)i});
+            }
+            else if (!colliding.empty())
+            {
+                // has collided
+                auto it = find(colliding.begin(), colliding.end(), (int)enemies.id[i]);
+                if (it != colliding.end())
+                {
+                    projectile->current_colliding.erase(*it);
+                    *it = colliding.back();
+                    colliding.pop_back();
+                }
+            }
+        }
+        sort(hits.begin(), hits.end());
+        for (auto &hit : hits)
+        {
+            // pierce used up, done with this projectile
+            if (!projectile->IsActive())
+                break;
+            Enemy *enemy = static_cast<Enemy *>(enemies.owner[hit.second]);
+            // New collision this frame
+            if (projectile->current_colliding.find(enemy->id) == projectile->current_colliding.end())
+            {
+                projectile->current_colliding.insert(enemy->id);
+                projectile->ReducePierceCount();
+                enemy->TakeDamage(projectile->getProjType(), GetDamageFalloff(1.0f, 0.0f, projectile->enemies_hit), projectile->source);
+            }
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Bodies.h"
+#include "raylib.h"
+#include <cstddef>
+
+/* The per-tick systems that work on the component tables (Bodies.h) instead of on Enemy / Projectile objects.
+ * They only go back to the object through owner for what's still in the classes: Destroy(), the pierce count and the damage.
+ * SimulateTick and QuietTick (GameState.cpp) run them, the order is what the old Update(dt) calls did per entity.
+ */
+
+/* one enemy row: remembers where it was, takes it off if it has walked off the map (bounds plus some slack),
+ * then steps it along its velocity, the sim LOD catches parked enemies up with this one row at a time
+ */
+void MoveEnemy(BodyTable &enemies, size_t row, const Rectangle &bounds, float dt);
+// every active enemy that isn't parked
+void MoveEnemies(BodyTable &enemies, const Rectangle &bounds, float dt);
+// every active projectile: taken off once it's out of range, otherwise flown along its velocity if it's BODY_MOVING
+void MoveProjectiles(BodyTable &projectiles, float dt);
+/* every projectile in play against every enemy in play (BodyTable::MarkInPlay), swept over the tick
+ * hits are recorded in the game's damage_events like before, nothing is applied here
+ */
+void CollideProjectiles(BodyTable &projectiles, const BodyTable &enemies);
@@ -0,0 +1,63 @@
+#include "Telemetry.h"
+#include "raylib.h"
+#include <chrono>
+#include <vector>
+using namespace std;
+
+bool TelemetryLog::Open(const char *path)
+{
+    Close();
+    file = fopen(path, "wb");
+    if (!file)
+        return false;
+    fwrite(TELEMETRY_MAGIC, 1, sizeof(TELEMETRY_MAGIC), file);
+    fwrite(&TELEMETRY_VERSION, sizeof(TELEMETRY_VERSION), 1, file);
+    stopping = false;
+    dropped = 0;
+    writer = thread(&TelemetryLog::WriterLoop, this);
+    return true;
+}
+
+void TelemetryLog::Close()
+{
+    if (!file)
+        return;
+    stopping = true;
+    writer.join();
+    fclose(file);
+    file = nullptr;
+    if (Dropped() > 0)
+        TraceLog(LOG_WARNING, "TELEMETRY: %llu events dropped, the writer couldn't keep up", Dropped());
+}
+
+void TelemetryLog::WriterLoop()
+{
+    vector<TelemetryEvent> batch(4096);
+    BinaryWriter bytes;
+    auto lastFlush = chrono::steady_clock::now();
+    while (true)
+    {
+        // read stopping first, so everything pushed before Close() is in the queue by the time it says empty
+        bool stop = stopping.load();
+        size_t count = queue.PopMany(batch.data(), batch.size());
+        if (count == 0)
+        {
+            if (stop)
+                break;
+            // nothing to do, a short nap instead of a condition variable the game thread would have to signal
+            this_thread::sleep_for(chrono::milliseconds(2));
+            continue;
+        }
+        bytes.clear();
+        for (size_t i = 0; i < count; i++)
+            batch[i].Write(bytes);
+        fwrite(bytes.data.data(), 1, bytes.data.size(), file);
+        // on disk a few times a second, a crash loses at most that much
+        if (chrono::steady_clock::now() - lastFlush > chrono::milliseconds(250))
+        {
+            fflush(file);
+            lastFlush = chrono::steady_clock::now();
+        }
+    }
+    fflush(file);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "Serialize.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+/* Gameplay telemetry: what happened in a game, event by event, in a compact binary log (.oztl)
+ * The game thread only pushes fixed size events into a lock-free queue, a writer thread
+ * of its own turns them into bytes and does all the file I/O, so a frame never waits on the disk.
+ * If the writer ever falls that far behind, events are dropped (and counted) rather than blocking.
+ * tools/telemetry_csv.cpp turns a log into CSV.
+ *
+ * File: "OZTL", u32 version, then one record after the other, RECORD_BYTES each:
+ *   u64 tick (GameState::simTick), u32 id, f32 value, u8 kind, u8 enemy type, u8 turret type
+ * Raw little-endian bytes like the snapshots (Serialize.h).
+ */
+enum class TelemetryKind : unsigned char
+{
+    NEW_GAME,   // id = seed, ticks start over from here
+    SPAWN,      // enemy, id = enemy id
+    LEAK,       // enemy, id = enemy id
+    KILL,       // enemy, turret = who landed the last hit, id = enemy id, value = overkill
+    DAMAGE,     // turret, value = everything it dealt this tick (one per turret type that hit anything)
+    BUILD,      // turret, id = tile index (row * cols + col), value = cost
+    UPGRADE,    // turret = the new tier, id = tile index, value = cost
+    SELL,       // turret, id = tile index, value = money back
+    WAVE_START, // id = wave number
+    WAVE_END,   // id = wave number
+    REWIND,     // the game went back to tick, anything logged after that tick never happened
+};
+const int TELEMETRY_KIND_COUNT = 11; // keep in sync with TelemetryKind
+
+inline const char *TelemetryKindName(TelemetryKind kind)
+{
+    static const char *names[TELEMETRY_KIND_COUNT] = {"new_game", "spawn", "leak", "kill", "damage", "build", "upgrade", "sell", "wave_start", "wave_end", "rewind"};
+    return (int)kind < TELEMETRY_KIND_COUNT ? names[(int)kind] : "unknown";
+}
+
+struct TelemetryEvent
+{
+    unsigned long long tick;
+    unsigned int id; // enemy ids are cut to their low 32 bits
+    float value;
+    TelemetryKind kind;
+    unsigned char enemy;  // EnemyType
+    unsigned char turret; // TurretType, TURRET_TYPE_COUNT = nobody in particular
+
+    static const int RECORD_BYTES = 8 + 4 + 4 + 3;
+    void Write(BinaryWriter &out) const
+    {
+        out.Write(tick);
+        out.Write(id);
+        out.Write(value);
+        out.WriteEnum(kind);
+        out.Write(enemy);
+        out.Write(turret);
+    }
+    void Read(BinaryReader &in)
+    {
+        tick = in.Read<unsigned long long>();
+        id = in.Read<unsigned int>();
+        value = in.Read<float>();
+        kind = in.ReadEnum<TelemetryKind>();
+        enemy = in.Read<unsigned char>();
+        turret = in.Read<unsigned char>();
+    }
+};
+
+static const char TELEMETRY_MAGIC[4] = {'O', 'Z', 'T', 'L'};
+static const unsigned int TELEMETRY_VERSION = 1;
+
+/* One log, fed by one game (one producer thread). GameState::telemetry points at it while it logs.
+ * Open() starts the writer thread, Close() (or the destructor) writes out whatever is still queued and stops it.
+ */
+class TelemetryLog
+{
+  public:
+    TelemetryLog() {}
+    TelemetryLog(const TelemetryLog &) = delete;
+    TelemetryLog &operator=(const TelemetryLog &) = delete;
+    ~TelemetryLog() { Close(); }
+
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+
+    // game thread only, never blocks
+    void Push(const TelemetryEvent &event)
+    {
+        if (!queue.Push(event))
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    unsigned long long Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+  private:
+    static const int QUEUE_EVENTS = 1 << 16; // a couple of seconds of a heavy wave at 60 ticks a second
+    SpscQueue<TelemetryEvent> queue{QUEUE_EVENTS};
+    FILE *file = nullptr;
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+    std::atomic<unsigned long long> dropped{0};
+
+    void WriterLoop();
+};
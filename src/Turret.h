@@ -1,6 +1,7 @@
 #pragma once
 #include "Enemy.h"
 #include "Entity.h"
+#include "GameState.h"
 #include "Map.h"
 #include "Particles.h"
 #include "Projectile.h"
@@ -10,6 +11,7 @@
 #include "raymath.h"
 #include "utils.h"
 #include <Config.h>
+#include <algorithm>
 #include <iostream>
 #include <memory> // for std::unique_ptr
 #include <vector>
@@ -23,6 +25,8 @@ class Turret : public Entity
 {
   public:
     // base properties
+    Vector2 position;
+    Vector2 velocity = {0, 0}; // never moves, only here because snapshots have one for every entity
     float radius;
     float range;
     Color color;
@@ -37,9 +41,14 @@ class Turret : public Entity
     float m_recoilOffset;
     Tile *tileOfTurret;
     TurretType turret;
+    int stats_slot = -1; // where StatsManager keeps this turret's damage/kills
+    // the stretches of path in range, as [from, to] of flow_field.dist, see EnemiesInReach()
+    std::vector<std::pair<int, int>> path_intervals;
+    unsigned int path_intervals_version = 0; // flow_field.version they were worked out for
 
     Turret(Vector2 pos, Tile *tile, float speed, TurretType t)
     {
+        kind = EntityKind::TURRET;
         position = pos;     // position of the turret
         gunRotation = 0.0f; // initial rotation of the gun (for visual aiming)
         tileOfTurret = tile;
@@ -48,6 +57,11 @@ class Turret : public Entity
         turret = t;
     }
 
+    Vector2 GetPosition() const override { return position; }
+    Vector2 GetVelocity() const override { return velocity; }
+    void SetPosition(Vector2 pos) override { position = pos; }
+    void SetVelocity(Vector2 vel) override { velocity = vel; }
+
     void Update(float deltaTime) override
     {
         // primitive update function
@@ -57,28 +71,18 @@ class Turret : public Entity
             recoilOffset = Lerp(recoilOffset, 0, 0.2f);
         }
     }
-    virtual void Update(float deltaTime, const std::vector<Enemy *> &targets, std::vector<std::unique_ptr<Entity>> &newProjectiles)
+    virtual void Update(float deltaTime, const FrameVector<Enemy *> &targets, FrameVector<std::unique_ptr<Entity>> &newProjectiles)
     {
-        Enemy *target = nullptr;
-        float closestDist = 999999.0f;
-
-        for (auto &e_ptr : targets)
-        {
-            if (!e_ptr->isVisible && turret != TurretType::SALVO)
-                continue;
-            if (turret == TurretType::SALVO && e_ptr->status_effect == StatusEffects::SLOWED)
-                continue;
-            float dist = Vector2Distance(position, e_ptr->GetPosition());
-            if (dist < range && dist < closestDist)
-            {
-                closestDist = dist;
-                target = e_ptr;
-            }
-        }
+        // salvo sees hidden enemies but ignores ones already slowed, everyone else only sees visible ones
+        bool isSalvo = turret == TurretType::SALVO;
+        int closest = game->enemy_table.FindClosest(position, range, isSalvo, isSalvo);
+        Enemy *target = closest >= 0 ? game->enemy_table.enemy[closest] : nullptr;
         if (target != nullptr)
         {
 
-            Vector2 aimPoint = CalculateInterceptPoint(target->GetPosition(), target->GetVelocity(), projectileSpeed);
+            // streams hit instantly, so no leading the target for those
+            bool stream = turret == TurretType::RIPPLE || turret == TurretType::SALVO;
+            Vector2 aimPoint = stream ? target->GetPosition() : CalculateInterceptPoint(target->GetPosition(), target->GetVelocity(), projectileSpeed);
 
             float targetAngle = atan2f(aimPoint.y - position.y, aimPoint.x - position.x) * RAD2DEG;
 
@@ -92,7 +96,7 @@ class Turret : public Entity
                 {
                 case TurretType::DUO:
                 {
-                    newProjectiles.push_back(std::make_unique<normal_bullet>(position, aimPoint));
+                    Fire(std::make_unique<normal_bullet>(position, aimPoint), newProjectiles);
                     break;
                 }
                 case TurretType::SMITE:
@@ -107,23 +111,25 @@ class Turret : public Entity
                         float shot_angle = central_angle + offset;
                         Vector2 dir = {cosf(shot_angle), sinf(shot_angle)};
                         Vector2 aim_point = Vector2Add(position, Vector2Scale(dir, smite_turret_range));
-                        newProjectiles.push_back(std::make_unique<shotgun_bullet>(position, aim_point));
+                        Fire(std::make_unique<shotgun_bullet>(position, aim_point), newProjectiles);
                     }
                     break;
                 }
                 case TurretType::LANCER:
                 {
-                    newProjectiles.push_back(std::make_unique<laser_bullet>(position, aimPoint));
+                    Fire(std::make_unique<laser_bullet>(position, aimPoint), newProjectiles);
                     break;
                 }
                 case TurretType::RIPPLE:
                 {
-                    newProjectiles.push_back(std::make_unique<flame_bullet>(position, aimPoint));
+                    FireStream(deltaTime, targets, ripple_stream_dps, flame_bullet_spread, ProjectileType::FLAME);
+                    game->particles.SpawnStream(position, {cosf(gunRotation * DEG2RAD), sinf(gunRotation * DEG2RAD)}, flame_bullet_speed, flame_bullet_spread, range, {235, 140, 108, 255}, ProjectileType::FLAME);
                     break;
                 }
                 case TurretType::SALVO:
                 {
-                    newProjectiles.push_back(std::make_unique<ice_bullet>(position, aimPoint));
+                    FireStream(deltaTime, targets, salvo_stream_dps, ice_stream_spread, ProjectileType::ICE_STREAM);
+                    game->particles.SpawnStream(position, {cosf(gunRotation * DEG2RAD), sinf(gunRotation * DEG2RAD)}, ice_stream_speed, ice_stream_spread, range, SKYBLUE, ProjectileType::ICE_STREAM);
                     break;
                 }
                 }
@@ -134,11 +140,121 @@ class Turret : public Entity
         }
     }
     virtual void Draw() override = 0;
-    virtual bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) = 0;
+
+    // tileOfTurret isn't saved, Snapshot.cpp finds it again from position
+    void Save(BinaryWriter &out) override
+    {
+        Entity::Save(out);
+        out.Write(radius);
+        out.Write(range);
+        out.Write(color);
+        out.Write(cooldownTimer);
+        out.Write(fireTimer);
+        out.Write(gunRotation);
+        out.Write(rotationSpeed);
+        out.Write(recoilOffset);
+        out.Write(m_recoilOffset);
+        out.Write(stats_slot);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Entity::Load(in);
+        in.Read(radius);
+        in.Read(range);
+        in.Read(color);
+        in.Read(cooldownTimer);
+        in.Read(fireTimer);
+        in.Read(gunRotation);
+        in.Read(rotationSpeed);
+        in.Read(recoilOffset);
+        in.Read(m_recoilOffset);
+        in.Read(stats_slot);
+    }
+    // beams and slow zones reach all the way to range
+    float GetDrawRadius() override { return range; }
+    // map is where selling / upgrading hands the tile over
+    virtual bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) = 0;
+    /* building, upgrading and selling without the buttons, for the batch runner's build orders (the buttons use them too)
+     * an upgrade is a new turret of the next tier on the same tile, paid from the current game, this one is destroyed
+     */
+    static std::unique_ptr<Turret> Make(TurretType type, Vector2 pos, Tile *tile);
+    static int Cost(TurretType type);
+    static TurretType NextTier(TurretType type); // type itself for the last tier
+    int SellValue() const;
+    bool Upgrade(vector<unique_ptr<Entity>> &entities, Map &map); // false on the last tier or without the money
+    void Sell(Map &map);
+    /* could any enemy be in range this tick, without looking at a single enemy position
+     * every path tile the range circle touches goes in by its distance to the exit, neighbouring distances merge,
+     * so a turret next to a straight stretch has one interval and one on a bend a couple
+     * enemy_table sorts the distances of the tiles enemies are on, each interval is then one binary search
+     * on a branching map two tiles far apart can share a distance, that only ever wakes a turret for nothing
+     */
+    bool EnemiesInReach()
+    {
+        if (path_intervals_version != game->flow_field.version)
+            BuildPathIntervals();
+        return game->enemy_table.AnyInIntervals(path_intervals);
+    }
+    void BuildPathIntervals()
+    {
+        path_intervals_version = game->flow_field.version;
+        PathIntervalsWithin(position, range, path_intervals);
+    }
+    /* how far from the turret an enemy can be and still be touched by it
+     * beams, streams and zones go by the enemy's edge, so range and a tile for the biggest radius,
+     * bullets fly on until projectile_max_range_sqr whatever they were aimed at, plus a step at sim_lod_max_dt and the radii
+     */
+    float InteractionReach() const
+    {
+        switch (turret)
+        {
+        case TurretType::DUO:
+        case TurretType::SMITE:
+        case TurretType::LANCER:
+            return sqrtf(projectile_max_range_sqr) + 2 * TILE_SIZE;
+        default:
+            return range + TILE_SIZE;
+        }
+    }
+    // the flow_field distances of every path tile with some part within reach of pos, as sorted, merged [from, to]
+    static void PathIntervalsWithin(Vector2 pos, float reach, std::vector<std::pair<int, int>> &out)
+    {
+        out.clear();
+        const float tile = game->flow_field.tile_size;
+        int firstRow = std::max(0, (int)floorf((pos.y - reach) / tile));
+        int lastRow = std::min(game->flow_field.rows - 1, (int)floorf((pos.y + reach) / tile));
+        int firstCol = std::max(0, (int)floorf((pos.x - reach) / tile));
+        int lastCol = std::min(game->flow_field.cols - 1, (int)floorf((pos.x + reach) / tile));
+        std::vector<int> dists;
+        for (int r = firstRow; r <= lastRow; r++)
+        {
+            for (int c = firstCol; c <= lastCol; c++)
+            {
+                int d = game->flow_field.dist[r * game->flow_field.cols + c];
+                if (d == -1)
+                    continue;
+                // closest point of the tile to the turret, an enemy anywhere on the tile could be in range
+                float dx = Clamp(pos.x, c * tile, (c + 1) * tile) - pos.x;
+                float dy = Clamp(pos.y, r * tile, (r + 1) * tile) - pos.y;
+                if (dx * dx + dy * dy <= reach * reach)
+                    dists.push_back(d);
+            }
+        }
+        std::sort(dists.begin(), dists.end());
+        for (int d : dists)
+        {
+            if (!out.empty() && d <= out.back().second + 1)
+                out.back().second = std::max(out.back().second, d);
+            else
+                out.push_back({d, d});
+        }
+    }
+
     // name is self-explanatory
-    void drawRangeOnHover(Vector2 pos)
+    // pos is the mouse in world coordinates, view is the camera view
+    void drawRangeOnHover(Vector2 pos, const Rectangle &view)
     {
-        if (CheckCollisionPointRec(pos, tileOfTurret->rect))
+        if (CheckCollisionPointRec(pos, {position.x - TILE_SIZE / 2, position.y - TILE_SIZE / 2, TILE_SIZE, TILE_SIZE}) && CheckCollisionCircleRec(position, range, view))
         {
             DrawCircleLines(position.x, position.y, range, YELLOW);
         }
@@ -258,8 +374,54 @@ class Turret : public Entity
 
   protected:
     inline static float y_offset = 200; // help in drawing
+
+    // hands a new projectile to the game loop, tagged with this turret's stats slot
+    void Fire(std::unique_ptr<Projectile> projectile, FrameVector<std::unique_ptr<Entity>> &newProjectiles)
+    {
+        projectile->source = stats_slot;
+        newProjectiles.push_back(std::move(projectile));
+    }
   private:
     float projectileSpeed;
+    std::vector<Enemy *> stream_hits; // reused every tick by FireStream
+
+    /* ripple and salvo stream, replaces the projectile they used to spawn every frame
+     * the stream is a cone of halfAngleDeg either side of the gun, out to range.
+     * Everything in it (invisible crawlers too, the old flames hit those as well) gets an equal share of dps * deltaTime,
+     * so the total stays the same however many enemies are inside.
+     * An enemy counts if any part of it is in the cone, like the old projectile's radius touching it.
+     * ICE_STREAM hits also slow, that's done when the damage is resolved.
+     */
+    void FireStream(float deltaTime, const FrameVector<Enemy *> &targets, float dps, float halfAngleDeg, ProjectileType type)
+    {
+        Vector2 dir = {cosf(gunRotation * DEG2RAD), sinf(gunRotation * DEG2RAD)};
+        stream_hits.clear();
+        for (auto *enemy : targets)
+        {
+            if (!enemy->IsActive())
+                continue;
+            Vector2 toEnemy = enemy->GetPosition() - position;
+            float dist = Vector2Length(toEnemy);
+            float r = enemy->GetRadius();
+            if (dist > range + r)
+                continue;
+            if (dist > r) // sitting right on the turret is always inside
+            {
+                float angle = acosf(Clamp(Vector2DotProduct(toEnemy, dir) / dist, -1.0f, 1.0f)) * RAD2DEG;
+                float widen = asinf(r / dist) * RAD2DEG;
+                if (angle > halfAngleDeg + widen)
+                    continue;
+            }
+            stream_hits.push_back(enemy);
+        }
+        if (stream_hits.empty())
+            return;
+        float share = dps * deltaTime / stream_hits.size();
+        for (auto *enemy : stream_hits)
+        {
+            enemy->TakeDamageByValue(type, share, stats_slot);
+        }
+    }
 
     /* Aim functionality
      * solves a simple quadratic equation
@@ -344,7 +506,7 @@ class smite_turret : public Turret
         DrawTexturePro(smiteTurretTexture, {0, 0, (float)smiteTurretTexture.width, (float)smiteTurretTexture.height}, // gun source rectangle
                        gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(smiteTurretTexture, {0, 0, (float)smiteTurretTexture.width, (float)smiteTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- SMITE ---", GRID_COLS * TILE_SIZE + 60, y_offset - 20, 40, BLACK);
@@ -358,9 +520,7 @@ class smite_turret : public Turret
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 150, y_offset + 180, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", smite_turret_cost - 200)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (smite_turret_cost - 200);
-            this->Destroy();
+            Sell(map);
             return true;
         }
         return false;
@@ -401,31 +561,25 @@ class ripple_turret : public Turret
         DrawTexturePro(rippleTurretTexture, {0, 0, (float)rippleTurretTexture.width, (float)rippleTurretTexture.height}, // gun source rectangle
                        gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(rippleTurretTexture, {0, 0, (float)rippleTurretTexture.width, (float)rippleTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- RIPPLE ---", GRID_COLS * TILE_SIZE + 40, y_offset - 20, 40, BLACK);
         DrawText("Level : 2", GRID_COLS * TILE_SIZE + 140, y_offset + 20, 20, BLACK);
-        DrawText("Projectiles : 1", GRID_COLS * TILE_SIZE + 140, y_offset + 40, 20, BLACK);
-        DrawText(TextFormat("Dmg/Proj : %.1f", flame_bullet_damage), GRID_COLS * TILE_SIZE + 140, y_offset + 60, 20, BLACK);
-        DrawText(TextFormat("Fire rate : %d", (int)ripple_turret_fire_rate), GRID_COLS * TILE_SIZE + 140, y_offset + 80, 20, BLACK);
+        DrawText("Stream", GRID_COLS * TILE_SIZE + 140, y_offset + 40, 20, BLACK);
+        DrawText(TextFormat("Damage/s : %.1f", ripple_stream_dps), GRID_COLS * TILE_SIZE + 140, y_offset + 60, 20, BLACK);
+        DrawText("(shared in cone)", GRID_COLS * TILE_SIZE + 140, y_offset + 80, 20, BLACK);
         DrawText(TextFormat("Range : %d tiles", (int)(ripple_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 100, 20, BLACK);
         DrawText(TextFormat("Spread : %.1f deg", flame_bullet_spread), GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
         Rectangle upgradeButton = {GRID_COLS * TILE_SIZE + 80, y_offset + 160, 120, 40};
-        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", smite_turret_cost)) && playerMoney >= smite_turret_cost)
+        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", smite_turret_cost)) && Upgrade(entities, map))
         {
-            entities.push_back(make_unique<smite_turret>(this->position, this->tileOfTurret));
-            playerMoney -= smite_turret_cost;
-            stat_manager.MoneySpent(smite_turret_cost);
-            this->Destroy();
             return true;
         }
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 220, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", ripple_turret_cost - 100)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (ripple_turret_cost - 100);
-            this->Destroy();
+            Sell(map);
             return true;
         }
 
@@ -473,7 +627,7 @@ class duo_turret : public Turret
                        gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
     }
 
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(duoTurretTexture, {0, 0, (float)duoTurretTexture.width, (float)duoTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- DUO ---", GRID_COLS * TILE_SIZE + 60, y_offset - 20, 40, BLACK);
@@ -484,20 +638,14 @@ class duo_turret : public Turret
         DrawText(TextFormat("Range : %d tiles", (int)(duo_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 100, 20, BLACK);
         DrawText("Spread : 0", GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
         Rectangle upgradeButton = {GRID_COLS * TILE_SIZE + 80, y_offset + 160, 120, 40};
-        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", ripple_turret_cost)) && playerMoney >= ripple_turret_cost)
+        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", ripple_turret_cost)) && Upgrade(entities, map))
         {
-            entities.push_back(make_unique<ripple_turret>(this->position, this->tileOfTurret));
-            playerMoney -= ripple_turret_cost;
-            stat_manager.MoneySpent(ripple_turret_cost);
-            this->Destroy();
             return true;
         }
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 220, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", duo_turret_cost - 20)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (duo_turret_cost - 20);
-            this->Destroy();
+            Sell(map);
             return true;
         }
         return false;
@@ -572,7 +720,7 @@ class meltdown_turret : public Turret
             recoilOffset = Lerp(recoilOffset, 0.0f, 0.1f);
         }
     }
-    void Update(float deltaTime, const std::vector<Enemy *> &targets, std::vector<std::unique_ptr<Entity>> &newProjectiles) override
+    void Update(float deltaTime, const FrameVector<Enemy *> &targets, FrameVector<std::unique_ptr<Entity>> &newProjectiles) override
     {
 
         float min_dist = 99999.0f;
@@ -581,7 +729,7 @@ class meltdown_turret : public Turret
         {
             if (!enemy->isVisible)
                 continue;
-            if (Vector2DistanceSqr(enemy->position, this->position) <= range * range)
+            if (Vector2DistanceSqr(enemy->GetPosition(), this->position) <= range * range)
             {
                 if (Vector2DistanceSqr(position, enemy->GetPosition()) <= min_dist)
                 {
@@ -609,13 +757,29 @@ class meltdown_turret : public Turret
                 {
                     if (CheckCollisionCircleLine(enemy->GetPosition(), enemy->GetRadius() + beamThickness / 2.0f, position, target_pos))
                     {
-                        enemy->TakeDamageByValue(ProjectileType::MELTDOWN_BEAM, meltdown_turret_dps * deltaTime);
+                        enemy->TakeDamageByValue(ProjectileType::MELTDOWN_BEAM, meltdown_turret_dps * deltaTime, stats_slot);
                     }
                 }
             }
         }
     }
 
+    void Save(BinaryWriter &out) override
+    {
+        Turret::Save(out);
+        out.Write(cooldown_timer);
+        out.Write(beam_timer);
+        out.WriteBool(is_active);
+        out.Write(target_pos);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Turret::Load(in);
+        in.Read(cooldown_timer);
+        in.Read(beam_timer);
+        is_active = in.ReadBool();
+        in.Read(target_pos);
+    }
     void Draw() override
     {
         DrawTexturePro(turretBaseTexture_2, {0, 0, (float)turretBaseTexture_2.width, (float)turretBaseTexture_2.height}, {position.x, position.y, (float)turretBaseTexture_2.width, (float)turretBaseTexture_2.height}, {(float)turretBaseTexture_2.width / 2.0f, (float)turretBaseTexture_2.height / 2.0f}, 0.0f, WHITE);
@@ -640,7 +804,7 @@ class meltdown_turret : public Turret
         DrawTexturePro(meltdownTurretTexture, {0, 0, (float)meltdownTurretTexture.width, (float)meltdownTurretTexture.height}, gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
         // I don't know why i declared so many intermediate variables. But it's done now and i'm too lazy to revert. Good bye, optimised RAM usage. (please have lots of ram)
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(meltdownTurretTexture, {0, 0, (float)meltdownTurretTexture.width, (float)meltdownTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- MELTDOWN ---", GRID_COLS * TILE_SIZE + 20, y_offset - 20, 40, BLACK);
@@ -652,9 +816,7 @@ class meltdown_turret : public Turret
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 150, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", meltdown_turret_cost - 300)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (meltdown_turret_cost - 300);
-            this->Destroy();
+            Sell(map);
             return true;
         }
         return false;
@@ -703,7 +865,7 @@ class cyclone_turret : public Turret
             recoilOffset = Lerp(recoilOffset, 0.0f, 0.5f);
         }
     }
-    void Update(float deltaTime, const std::vector<Enemy *> &targets, std::vector<std::unique_ptr<Entity>> &newProjectiles) override
+    void Update(float deltaTime, const FrameVector<Enemy *> &targets, FrameVector<std::unique_ptr<Entity>> &newProjectiles) override
     {
         if (!is_active)
         {
@@ -713,7 +875,7 @@ class cyclone_turret : public Turret
             {
                 if (!enemy->isVisible)
                     continue;
-                if (Vector2DistanceSqr(enemy->position, this->position) <= range * range)
+                if (Vector2DistanceSqr(enemy->GetPosition(), this->position) <= range * range)
                 {
                     if (Vector2DistanceSqr(position, enemy->GetPosition()) <= min_dist)
                     {
@@ -743,7 +905,7 @@ class cyclone_turret : public Turret
                         }
                         if (CheckCollisionCircleLine(enemy->GetPosition(), enemy->GetRadius(), position, target_pos))
                         {
-                            enemy->TakeDamage(ProjectileType::CYCLONE_BEAM, GetDamageFalloff(Vector2DistanceSqr(enemy->GetPosition(), position), range, enemy_hit));
+                            enemy->TakeDamage(ProjectileType::CYCLONE_BEAM, GetDamageFalloff(Vector2DistanceSqr(enemy->GetPosition(), position), range, enemy_hit), stats_slot);
                             enemy_hit++;
                         }
                     }
@@ -752,6 +914,22 @@ class cyclone_turret : public Turret
         }
     }
 
+    void Save(BinaryWriter &out) override
+    {
+        Turret::Save(out);
+        out.Write(cooldown_timer);
+        out.Write(beam_timer);
+        out.WriteBool(is_active);
+        out.Write(target_pos);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Turret::Load(in);
+        in.Read(cooldown_timer);
+        in.Read(beam_timer);
+        is_active = in.ReadBool();
+        in.Read(target_pos);
+    }
     void Draw() override
     {
         DrawTexturePro(turretBaseTexture, {0, 0, (float)turretBaseTexture.width, (float)turretBaseTexture.height}, {position.x, position.y, (float)turretBaseTexture.width, (float)turretBaseTexture.height}, {(float)turretBaseTexture.width / 2.0f, (float)turretBaseTexture.height / 2.0f}, 0.0f, WHITE);
@@ -778,7 +956,7 @@ class cyclone_turret : public Turret
             EndBlendMode();
         }
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(cycloneTurretTexture, {0, 0, (float)cycloneTurretTexture.width, (float)cycloneTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- CYCLONE ---", GRID_COLS * TILE_SIZE + 60, y_offset - 20, 40, BLACK);
@@ -788,20 +966,14 @@ class cyclone_turret : public Turret
         DrawText(TextFormat("Fire rate : %.2f", 1 / (cyclone_turret_cooldown_timer + cyclone_turret_beam_timer)), GRID_COLS * TILE_SIZE + 140, y_offset + 100, 20, BLACK);
         DrawText(TextFormat("Range : %d tiles", (int)(cyclone_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
         Rectangle upgradeButton = {GRID_COLS * TILE_SIZE + 80, y_offset + 160, 120, 40};
-        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", meltdown_turret_cost)) && playerMoney >= meltdown_turret_cost)
+        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", meltdown_turret_cost)) && Upgrade(entities, map))
         {
-            entities.push_back(make_unique<meltdown_turret>(this->position, this->tileOfTurret));
-            playerMoney -= meltdown_turret_cost;
-            stat_manager.MoneySpent(meltdown_turret_cost);
-            this->Destroy();
             return true;
         }
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 220, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", cyclone_turret_cost - 200)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (cyclone_turret_cost - 200);
-            this->Destroy();
+            Sell(map);
             return true;
         }
         return false;
@@ -843,7 +1015,7 @@ class lancer_turret : public Turret
         DrawTexturePro(lancerTurretTexture, {0, 0, (float)lancerTurretTexture.width, (float)lancerTurretTexture.height}, // gun source rectangle
                        gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(lancerTurretTexture, {0, 0, (float)lancerTurretTexture.width, (float)lancerTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- LANCER ---", GRID_COLS * TILE_SIZE + 60, y_offset - 20, 40, BLACK);
@@ -854,20 +1026,14 @@ class lancer_turret : public Turret
         DrawText(TextFormat("Fire rate : %d", (int)lancer_turret_fire_rate), GRID_COLS * TILE_SIZE + 140, y_offset + 100, 20, BLACK);
         DrawText(TextFormat("Range : %d tiles", (int)(lancer_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
         Rectangle upgradeButton = {GRID_COLS * TILE_SIZE + 80, y_offset + 160, 120, 40};
-        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", cyclone_turret_cost)) && playerMoney >= cyclone_turret_cost)
+        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", cyclone_turret_cost)) && Upgrade(entities, map))
         {
-            entities.push_back(make_unique<cyclone_turret>(this->position, this->tileOfTurret));
-            playerMoney -= cyclone_turret_cost;
-            stat_manager.MoneySpent(cyclone_turret_cost);
-            this->Destroy();
             return true;
         }
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 220, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", lancer_turret_cost - 50)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (lancer_turret_cost - 50);
-            this->Destroy();
+            Sell(map);
             return true;
         }
 
@@ -923,21 +1089,19 @@ class salvo_turret : public Turret
         DrawTexturePro(salvoTurretTexture, {0, 0, (float)salvoTurretTexture.width, (float)salvoTurretTexture.height}, // gun source rectangle
                        gunDestRec, gunOrigin, gunRotation + 90.0f, WHITE);
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(salvoTurretTexture, {0, 0, (float)salvoTurretTexture.width, (float)salvoTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- SALVO ---", GRID_COLS * TILE_SIZE + 20, y_offset - 20, 40, BLACK);
         DrawText("Level : 2", GRID_COLS * TILE_SIZE + 140, y_offset + 20, 20, BLACK);
-        DrawText(TextFormat("Damage/proj : %.1f", ice_stream_damage), GRID_COLS * TILE_SIZE + 140, y_offset + 60, 20, BLACK);
-        DrawText(TextFormat("Fire rate : %.1f", salvo_turret_fire_rate), GRID_COLS * TILE_SIZE + 140, y_offset + 80, 20, BLACK);
+        DrawText(TextFormat("Damage/s : %.1f", salvo_stream_dps), GRID_COLS * TILE_SIZE + 140, y_offset + 60, 20, BLACK);
+        DrawText("Slows all in stream", GRID_COLS * TILE_SIZE + 140, y_offset + 80, 20, BLACK);
         DrawText(TextFormat("Spread : %.1f deg", ice_stream_spread), GRID_COLS * TILE_SIZE + 140, y_offset + 100, 20, BLACK);
-        DrawText(TextFormat("Range : %d tiles", (int)(meltdown_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
+        DrawText(TextFormat("Range : %d tiles", (int)(salvo_turret_range / TILE_SIZE)), GRID_COLS * TILE_SIZE + 140, y_offset + 120, 20, BLACK);
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 150, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", salvo_turret_cost - 200)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (salvo_turret_cost - 200);
-            this->Destroy();
+            Sell(map);
             return true;
         }
 
@@ -986,7 +1150,7 @@ class wave_turret : public Turret
         }
     }
 
-    void Update(float deltaTime, const std::vector<Enemy *> &targets, std::vector<std::unique_ptr<Entity>> &newProjectiles) override
+    void Update(float deltaTime, const FrameVector<Enemy *> &targets, FrameVector<std::unique_ptr<Entity>> &newProjectiles) override
     {
         if (!is_active)
         {
@@ -995,12 +1159,26 @@ class wave_turret : public Turret
 
         for (auto &enemy : targets)
         {
-            if (Vector2DistanceSqr(enemy->position, this->position) <= range * range)
+            if (Vector2DistanceSqr(enemy->GetPosition(), this->position) <= range * range)
             {
                 enemy->status_effect = StatusEffects::SLOWED;
             }
         }
     }
+    void Save(BinaryWriter &out) override
+    {
+        Turret::Save(out);
+        out.Write(active_timer);
+        out.Write(cooldown_timer);
+        out.WriteBool(is_active);
+    }
+    void Load(BinaryReader &in) override
+    {
+        Turret::Load(in);
+        in.Read(active_timer);
+        in.Read(cooldown_timer);
+        is_active = in.ReadBool();
+    }
     void Draw() override
     {
         Vector2 baseOrigin = {(float)turretBaseTexture.width / 2.0f, (float)turretBaseTexture.height / 2.0f};
@@ -1014,7 +1192,7 @@ class wave_turret : public Turret
             DrawCircleV(position, range, Fade(SKYBLUE, 0.2f));
         }
     }
-    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities) override
+    bool DrawTurretInfo(vector<unique_ptr<Entity>> &entities, Map &map) override
     {
         DrawTexturePro(waveTurretTexture, {0, 0, (float)waveTurretTexture.width, (float)waveTurretTexture.height}, {GRID_COLS * TILE_SIZE + 160, y_offset - 70, 2 * (float)duoTurretTexture.width, 2 * (float)duoTurretTexture.height}, {(float)duoTurretTexture.width / 2, (float)duoTurretTexture.height / 2}, 0.0f, WHITE);
         DrawText("--- WAVE ---", GRID_COLS * TILE_SIZE + 20, y_offset - 20, 40, BLACK);
@@ -1026,18 +1204,12 @@ class wave_turret : public Turret
         Rectangle sellButton = {GRID_COLS * TILE_SIZE + 220, y_offset + 160, 120, 40};
         if (GuiButton(sellButton, TextFormat("Sell (%d)", wave_turret_cost - 100)))
         {
-            this->tileOfTurret->hasTurret = false;
-            playerMoney += (wave_turret_cost - 100);
-            this->Destroy();
+            Sell(map);
             return true;
         }
         Rectangle upgradeButton = {GRID_COLS * TILE_SIZE + 80, y_offset + 160, 120, 40};
-        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", salvo_turret_cost)) && playerMoney >= salvo_turret_cost)
+        if (GuiButton(upgradeButton, TextFormat("Upgrade (%d)", salvo_turret_cost)) && Upgrade(entities, map))
         {
-            entities.push_back(make_unique<salvo_turret>(this->position, this->tileOfTurret));
-            playerMoney -= salvo_turret_cost;
-            stat_manager.MoneySpent(salvo_turret_cost);
-            this->Destroy();
             return true;
         }
 
@@ -1057,4 +1229,123 @@ class wave_turret : public Turret
 
   private:
     float GetRotationSpeed() override { return rotationSpeed; }
-};
\ No newline at end of file
+};
+
+// ---- defined down here, they need every turret class ----
+inline std::unique_ptr<Turret> Turret::Make(TurretType type, Vector2 pos, Tile *tile)
+{
+    switch (type)
+    {
+    case TurretType::DUO:
+        return std::make_unique<duo_turret>(pos, tile);
+    case TurretType::RIPPLE:
+        return std::make_unique<ripple_turret>(pos, tile);
+    case TurretType::SMITE:
+        return std::make_unique<smite_turret>(pos, tile);
+    case TurretType::LANCER:
+        return std::make_unique<lancer_turret>(pos, tile);
+    case TurretType::CYCLONE:
+        return std::make_unique<cyclone_turret>(pos, tile);
+    case TurretType::MELTDOWN:
+        return std::make_unique<meltdown_turret>(pos, tile);
+    case TurretType::WAVE:
+        return std::make_unique<wave_turret>(pos, tile);
+    case TurretType::SALVO:
+        return std::make_unique<salvo_turret>(pos, tile);
+    }
+    return nullptr;
+}
+
+inline int Turret::Cost(TurretType type)
+{
+    switch (type)
+    {
+    case TurretType::DUO:
+        return duo_turret_cost;
+    case TurretType::RIPPLE:
+        return ripple_turret_cost;
+    case TurretType::SMITE:
+        return smite_turret_cost;
+    case TurretType::LANCER:
+        return lancer_turret_cost;
+    case TurretType::CYCLONE:
+        return cyclone_turret_cost;
+    case TurretType::MELTDOWN:
+        return meltdown_turret_cost;
+    case TurretType::WAVE:
+        return wave_turret_cost;
+    case TurretType::SALVO:
+        return salvo_turret_cost;
+    }
+    return 0;
+}
+
+inline TurretType Turret::NextTier(TurretType type)
+{
+    switch (type)
+    {
+    case TurretType::DUO:
+        return TurretType::RIPPLE;
+    case TurretType::RIPPLE:
+        return TurretType::SMITE;
+    case TurretType::LANCER:
+        return TurretType::CYCLONE;
+    case TurretType::CYCLONE:
+        return TurretType::MELTDOWN;
+    case TurretType::WAVE:
+        return TurretType::SALVO;
+    default:
+        return type;
+    }
+}
+
+// what the sell buttons always gave back, less for the pricier tiers
+inline int Turret::SellValue() const
+{
+    switch (turret)
+    {
+    case TurretType::DUO:
+        return duo_turret_cost - 20;
+    case TurretType::RIPPLE:
+        return ripple_turret_cost - 100;
+    case TurretType::SMITE:
+        return smite_turret_cost - 200;
+    case TurretType::LANCER:
+        return lancer_turret_cost - 50;
+    case TurretType::CYCLONE:
+        return cyclone_turret_cost - 200;
+    case TurretType::MELTDOWN:
+        return meltdown_turret_cost - 300;
+    case TurretType::WAVE:
+        return wave_turret_cost - 100;
+    case TurretType::SALVO:
+        return salvo_turret_cost - 200;
+    }
+    return 0;
+}
+
+inline bool Turret::Upgrade(vector<unique_ptr<Entity>> &entities, Map &map)
+{
+    TurretType next = NextTier(turret);
+    int cost = Cost(next);
+    if (next == turret || game->playerMoney < cost)
+        return false;
+    auto upgraded = Make(next, position, tileOfTurret);
+    upgraded->stats_slot = game->stat_manager.TurretBuilt(next, cost);
+    game->stat_manager.TurretRemoved(stats_slot);
+    map.PlaceTurret(tileOfTurret, upgraded.get());
+    entities.push_back(std::move(upgraded));
+    game->playerMoney -= cost;
+    game->Record(TelemetryKind::UPGRADE, map.IndexOf(tileOfTurret), (float)cost, 0, (int)next);
+    Destroy();
+    return true;
+}
+
+inline void Turret::Sell(Map &map)
+{
+    map.RemoveTurret(tileOfTurret);
+    game->stat_manager.TurretRemoved(stats_slot);
+    game->playerMoney += SellValue();
+    game->Record(TelemetryKind::SELL, map.IndexOf(tileOfTurret), (float)SellValue(), 0, (int)turret);
+    Destroy();
+}
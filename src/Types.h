@@ -1,6 +1,19 @@
 #pragma once
 
 // types of different entity declaration
+// which branch of the Entity hierarchy something is, so the game loop can sort them without dynamic_cast
+enum class EntityKind
+{
+    TURRET,
+    ENEMY,
+    PROJECTILE,
+};
+// how enemies find their way, switched with F6 between waves
+enum class NavMode
+{
+    WAYPOINTS,  // each enemy walks one of enemy_paths corner by corner
+    FLOW_FIELD, // each enemy asks flow_field for the next tile whenever it reaches one
+};
 enum class ProjectileType
 {
     DUO_BASIC,
@@ -25,6 +38,7 @@ enum class TurretType
     WAVE,
     SALVO,
 };
+const int TURRET_TYPE_COUNT = 8; // keep in sync with TurretType, used to size per-type arrays
 enum class StatusEffects
 {
     NONE,
@@ -38,4 +52,5 @@ enum class EnemyType
     POLY,
     LOCUS,
     ANTUMBRA,
-};
\ No newline at end of file
+};
+const int ENEMY_TYPE_COUNT = 6; // keep in sync with EnemyType
@@ -0,0 +1,160 @@
+#include "Wave.h"
+#include "Enemy.h"
+#include "GameState.h"
+#include "StatsManager.h"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+void WaveManager::StartNextWave()
+{
+    if (state == State::WAITING_FOR_PLAYER && !IsFinished())
+    {
+        state = State::SPAWNING;
+        currentCommandIndex = 0;
+        spawnTimer = 0;
+        game->stat_manager.WaveStarted(GetWaveNumber());
+        game->Record(TelemetryKind::WAVE_START, GetWaveNumber());
+    }
+}
+
+void WaveManager::Update(float deltaTime, vector<unique_ptr<Entity>> &entities, int activeEnemies)
+{
+    if (state == State::FINISHED)
+        return;
+
+    if (state == State::SPAWNING)
+    {
+        spawnTimer -= deltaTime;
+        if (spawnTimer <= 0)
+        {
+            const vector<SpawnCommand> &script = (*scripts)[currentWaveIndex];
+
+            const SpawnCommand &command = script[currentCommandIndex];
+
+            int waveNum = currentWaveIndex + 1;
+            switch (command.type)
+            {
+            case EnemyType::FLARE:
+                entities.push_back(make_unique<flare_enemy>());
+                break;
+            case EnemyType::MONO:
+                entities.push_back(make_unique<mono_enemy>());
+                break;
+            case EnemyType::LOCUS:
+                entities.push_back(make_unique<locus_enemy>());
+                break;
+            case EnemyType::CRAWLER:
+                entities.push_back(make_unique<crawler_enemy>()); break;
+            case EnemyType::POLY:
+                entities.push_back(make_unique<poly_enemy>());
+                break;
+            case EnemyType::ANTUMBRA:
+                entities.push_back(make_unique<antumbra_enemy>());
+                break;
+            }
+            game->Record(TelemetryKind::SPAWN, static_cast<Enemy *>(entities.back().get())->id, 0.0f, (int)command.type);
+
+            spawnTimer = command.delayUntilNext;
+            currentCommandIndex++;
+            if (currentCommandIndex >= script.size())
+            {
+                state = State::WAVE_IN_PROGRESS; // Done spawning, now just wait
+            }
+        }
+    }
+    else if (state == State::WAVE_IN_PROGRESS)
+    {
+        // wait for all enemies death
+        if (activeEnemies == 0)
+        {
+            game->stat_manager.WaveEnded();
+            game->Record(TelemetryKind::WAVE_END, GetWaveNumber());
+            currentWaveIndex++;
+
+            // Check if the completed wave was a boss wave
+            if (currentWaveIndex > 0 && (currentWaveIndex % BOSS_WAVE_INTERVAL == 0))
+            {
+                currentStage++;
+                game->enemy_health_multiplier += 1.0f; // Permanently increase health of all future enemies
+            }
+
+            if (currentWaveIndex >= (int)scripts->size())
+            {
+                state = State::FINISHED; // win condition?
+            }
+            else
+            {
+                state = State::WAITING_FOR_PLAYER;
+            }
+        }
+    }
+}
+
+// "crawler" and "Crawler" are both fine in a wave file
+static bool EqualsIgnoreCase(const string &a, const char *b)
+{
+    size_t i = 0;
+    for (; i < a.size() && b[i]; i++)
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+            return false;
+    return i == a.size() && !b[i];
+}
+
+shared_ptr<const WaveScripts> WaveManager::LoadScripts(const char *path, string &error)
+{
+    ifstream file(path);
+    if (!file)
+    {
+        error = "can't open file";
+        return nullptr;
+    }
+    WaveScripts waves;
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        lineNumber++;
+        istringstream in(line);
+        string word;
+        if (!(in >> word) || word[0] == '#')
+            continue;
+        if (word == "wave")
+        {
+            waves.emplace_back();
+            continue;
+        }
+        // an enemy name, by the same names the stats use
+        int type = 0;
+        while (type < ENEMY_TYPE_COUNT && !EqualsIgnoreCase(word, StatsManager::EnemyName((EnemyType)type)))
+            type++;
+        float delay = 0.0f;
+        if (type == ENEMY_TYPE_COUNT || !(in >> delay) || delay < 0.0f || waves.empty())
+        {
+            error = "line " + to_string(lineNumber) + ": expected <enemy> <delay> [xN] after a wave line";
+            return nullptr;
+        }
+        int count = 1;
+        string repeat;
+        if (in >> repeat && (repeat[0] != 'x' || (count = atoi(repeat.c_str() + 1)) <= 0))
+        {
+            error = "line " + to_string(lineNumber) + ": bad repeat " + repeat;
+            return nullptr;
+        }
+        waves.back().insert(waves.back().end(), count, SpawnCommand{(EnemyType)type, delay});
+    }
+    for (size_t i = 0; i < waves.size(); i++)
+    {
+        if (waves[i].empty())
+        {
+            error = "wave " + to_string(i + 1) + " has no enemies";
+            return nullptr;
+        }
+    }
+    if (waves.empty())
+    {
+        error = "no waves";
+        return nullptr;
+    }
+    return make_shared<const WaveScripts>(std::move(waves));
+}
@@ -1,9 +1,10 @@
 #pragma once
 
-#include "Config.h"
-#include "Enemy.h"
 #include "Entity.h"
+#include "Serialize.h"
+#include "Types.h"
 #include <memory>
+#include <string>
 #include <vector>
 using namespace std;
 struct SpawnCommand
@@ -11,6 +12,8 @@ struct SpawnCommand
     EnemyType type;
     float delayUntilNext; // time to next spawn
 };
+// every wave of a game, each one a list of spawns
+using WaveScripts = vector<vector<SpawnCommand>>;
 
 // --- WaveManager Class ---    
 // Handles spawning of waves and storing their data
@@ -23,15 +26,48 @@ class WaveManager
     int GetStageNumber() { return currentStage; }
     bool IsWaveActive() { return state == State::SPAWNING || state == State::WAVE_IN_PROGRESS; }       
     int GetWavesUntilBoss() { return BOSS_WAVE_INTERVAL - (currentWaveIndex % BOSS_WAVE_INTERVAL); }
-    int GetTotalWaves() { return (int)(allWaveScripts.size()); }
+    int GetTotalWaves() { return (int)(scripts->size()); }
     bool IsFinished() { return state == State::FINISHED; }
 
-    const int BOSS_WAVE_INTERVAL = 10; // A boss appears every 10 waves
+    static const int BOSS_WAVE_INTERVAL = 10; // A boss appears every 10 waves
 
     bool CanStartNextWave() { return state == State::WAITING_FOR_PLAYER; }
 
-    WaveManager()
+    WaveManager() : scripts(DefaultScripts())
     {
+        state = State::WAITING_FOR_PLAYER; // Start waiting for the player
+        currentWaveIndex = 0;
+        currentCommandIndex = 0;
+        spawnTimer = 0;
+    }
+
+    /* the wave scripts are never changed once built, so every game (and every copy a snapshot load makes)
+     * points at the same ones instead of carrying its own
+     */
+    static const shared_ptr<const WaveScripts> &DefaultScripts()
+    {
+        static const shared_ptr<const WaveScripts> scripts = BuildDefaultScripts();
+        return scripts;
+    }
+    /* Wave file (.ozw), plain text like the maps
+     *   # comment
+     *   wave                        starts the next wave
+     *   <enemy> <delay> [xN]        spawn (N of them), delay = seconds until the next spawn
+     *     enemy is flare, mono, crawler, poly, locus or antumbra
+     * nullptr (and the reason in error) if the file is missing, broken or has no waves
+     */
+    static shared_ptr<const WaveScripts> LoadScripts(const char *path, string &error);
+    // plays these from now on, back at wave 1
+    void SetScripts(shared_ptr<const WaveScripts> newScripts)
+    {
+        scripts = std::move(newScripts);
+        reset();
+    }
+
+    // the built-in waves
+    static shared_ptr<const WaveScripts> BuildDefaultScripts()
+    {
+        WaveScripts allWaveScripts;
         // 'allWaveScripts' is a vector of wave scripts
         // a wave script is a vector of SpawnCommands
 
@@ -182,100 +218,39 @@ class WaveManager
 
         });
 
-        state = State::WAITING_FOR_PLAYER; // Start waiting for the player
-        currentWaveIndex = 0;
-        currentCommandIndex = 0;
-        spawnTimer = 0;
+        return make_shared<const WaveScripts>(std::move(allWaveScripts));
     }
 
-    void StartNextWave()
+    void StartNextWave();
+    // spawns into entities, the enemies go by the current game's paths (Wave.cpp)
+    void Update(float deltaTime, vector<unique_ptr<Entity>> &entities, int activeEnemies);
+    // only the progress, the wave scripts themselves are shared and never saved
+    void Save(BinaryWriter &out)
     {
-        if (state == State::WAITING_FOR_PLAYER && !IsFinished())
-        {
-            state = State::SPAWNING;
-            currentCommandIndex = 0;
-            spawnTimer = 0;
-        }
+        out.Write(currentWaveIndex);
+        out.Write(currentCommandIndex);
+        out.Write(currentStage);
+        out.Write(spawnTimer);
+        out.WriteEnum(state);
     }
-    
-    void Update(float deltaTime, vector<unique_ptr<Entity>> &entities, int activeEnemies)
+    void Load(BinaryReader &in)
     {
-        if (state == State::FINISHED)
-            return;
-
-        if (state == State::SPAWNING)
-        {
-            spawnTimer -= deltaTime;
-            if (spawnTimer <= 0)
-            {
-                vector<SpawnCommand> &script = allWaveScripts[currentWaveIndex];
-
-                SpawnCommand &command = script[currentCommandIndex];
-
-                int waveNum = currentWaveIndex + 1;
-                switch (command.type)
-                {
-                case EnemyType::FLARE:
-                    entities.push_back(make_unique<flare_enemy>());
-                    break;
-                case EnemyType::MONO:
-                    entities.push_back(make_unique<mono_enemy>());
-                    break;
-                case EnemyType::LOCUS:
-                    entities.push_back(make_unique<locus_enemy>());
-                    break;
-                case EnemyType::CRAWLER:
-                    entities.push_back(make_unique<crawler_enemy>()); break;
-                case EnemyType::POLY:
-                    entities.push_back(make_unique<poly_enemy>());
-                    break;
-                case EnemyType::ANTUMBRA:
-                    entities.push_back(make_unique<antumbra_enemy>());
-                    break;
-                }
-
-                spawnTimer = command.delayUntilNext;
-                currentCommandIndex++;
-                if (currentCommandIndex >= script.size())
-                {
-                    state = State::WAVE_IN_PROGRESS; // Done spawning, now just wait
-                }
-            }
-        }
-        else if (state == State::WAVE_IN_PROGRESS)
-        {
-            // wait for all enemies death
-            if (activeEnemies == 0)
-            {
-                currentWaveIndex++;
-
-                // Check if the completed wave was a boss wave
-                if (currentWaveIndex > 0 && (currentWaveIndex % BOSS_WAVE_INTERVAL == 0))
-                {
-                    currentStage++;
-                    enemy_health_multiplier += 1.0f; // Permanently increase health of all future enemies
-                }
-
-                if (currentWaveIndex >= allWaveScripts.size())
-                {
-                    state = State::FINISHED; // win condition?
-                }
-                else
-                {
-                    state = State::WAITING_FOR_PLAYER;
-                }
-            }
-        }
+        in.Read(currentWaveIndex);
+        in.Read(currentCommandIndex);
+        in.Read(currentStage);
+        in.Read(spawnTimer);
+        state = in.ReadEnum<State>();
     }
     void reset(){
         state = State::WAITING_FOR_PLAYER;
         currentWaveIndex = 0;
+        currentStage = 1;
         currentCommandIndex = 0;
         spawnTimer = 0;
     }
 
   private:
-    vector<vector<SpawnCommand>> allWaveScripts;
+    shared_ptr<const WaveScripts> scripts;
     int currentWaveIndex; // which wave we're on
     int currentCommandIndex; // which command in the wave script we're on
     int currentStage = 1;
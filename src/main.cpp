@@ -7,10 +7,22 @@
 #include "scenes/intro.h"
 #include "scenes/settings.h"
 #include <raylib.h>
+#include <cstdlib>
+#include <string>
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
-int main()
+int main(int argc, char **argv)
 {
+    // ./output --map maps/big.ozm --telemetry game.oztl --metrics 9464
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--map")
+            map_file = argv[i + 1];
+        else if (std::string(argv[i]) == "--telemetry")
+            telemetry_file = argv[i + 1];
+        else if (std::string(argv[i]) == "--metrics")
+            metrics_port = std::atoi(argv[i + 1]);
+    }
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     SetConfigFlags(FLAG_VSYNC_HINT);
     InitWindow(screenWidth, screenHeight, "Outpost Zero");
@@ -40,10 +52,14 @@ int main()
         }
 
         EndDrawing();
+        // everything put on the frame arena this frame is gone now
+        frame_arena.Reset();
+        heap_stats.EndFrame();
     }
     Turret::DestroyTextures();
     Projectile::DestroyTextures();
     Enemy::DestroyTextures();
+    ParticleSystem::DestroyTextures();
     CloseWindow();
     return 0;
 }
@@ -1,14 +1,19 @@
 // Game.cpp
 // standard includes
 #include <algorithm>
+#include <climits>
+#include <cstdio>
 #include <memory>
 #include <vector>
 // custom includes
 #include "Config.h"
 #include "Enemy.h"
 #include "Entity.h"
+#include "GameState.h"
 #include "Map.h"
+#include "Metrics.h"
 #include "Projectile.h"
+#include "Snapshot.h"
 #include "Turret.h"
 #include "Wave.h"
 #include "raygui.h"
@@ -25,29 +30,192 @@ enum class buildState
 };
 
 static buildState current_build;
-static Map gameMap;
+static TelemetryLog telemetryLog; // --telemetry, outlives mainGame so nothing logs into a closed log
+static GameState mainGame; // the one game this scene shows and plays
+static MetricsServer metricsServer; // --metrics, started with the first game and left running
+static int frameTicks = 0;          // ticks the update pass ran this frame
+static unsigned long long ticksSimulated = 0; // every tick run since startup, played or resolved, for the metrics
+static float ticksPerSecond = 0.0f; // smoothed, for the metrics
 static bool initialized = false;
-static Camera2D camera = {0};
 static bool gameOver = false;
 static bool gameWon = false;
-static vector<unique_ptr<Entity>> entities; // Use a vector to hold all our entities
-static WaveManager wave_manager;
+static bool statsExported = false;
+static double snapshotMs = 0.0; // how long the last quick save / load took, with file io
 static Turret *currentTurret = nullptr;
+static bool rewindOpen = false;   // rewind panel is up, the game is paused while it is
+static float rewindTarget = 0.0f; // tick picked on the slider
+// game speed, ticks per rendered frame, 0 = as many as fit in sim_time_budget
+static const int SPEED_MODES[] = {1, 2, 4, 8, 0};
+static const int SPEED_MODE_COUNT = sizeof(SPEED_MODES) / sizeof(SPEED_MODES[0]);
+static int speedMode = 0;
+static bool showDebug = false;    // F1, the debug lines on the side panel and the debug keys, off for playing
+static bool showCoverage = false; // H, turret coverage heatmap over the map
+static float effectiveSpeed = 1.0f; // ticks actually run per frame, smoothed for the HUD
+static float lastWorkTime = 0.0f;   // seconds Game() took last frame, without the vsync wait, for the particle budget
+// last instant resolve, shown for a few seconds
+static char resolveSummary[160] = "";
+static double resolveShownAt = -100.0;
+
+/* Camera controls
+ * WASD / arrow keys or right mouse drag to pan, mouse wheel to zoom (towards the cursor)
+ * HOME puts it back where it started
+ */
+static void ResetGameCamera()
+{
+    Vector2 screenCenter = {(float)screenWidth / 2, (float)screenHeight / 2};
+    mainGame.camera.target = screenCenter;
+    mainGame.camera.offset = screenCenter;
+    mainGame.camera.rotation = 0.0f;
+    mainGame.camera.zoom = 1.0f;
+}
+static void UpdateGameCamera()
+{
+    float pan = camera_pan_speed * GetFrameTime() / mainGame.camera.zoom;
+    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT))
+        mainGame.camera.target.x -= pan;
+    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT))
+        mainGame.camera.target.x += pan;
+    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP))
+        mainGame.camera.target.y -= pan;
+    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN))
+        mainGame.camera.target.y += pan;
+    if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+    {
+        mainGame.camera.target = Vector2Add(mainGame.camera.target, Vector2Scale(GetMouseDelta(), -1.0f / mainGame.camera.zoom));
+    }
+
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0)
+    {
+        // zoom around the cursor, so the thing under it stays under it
+        Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), mainGame.camera);
+        mainGame.camera.offset = GetMousePosition();
+        mainGame.camera.target = mouseWorld;
+        mainGame.camera.zoom = Clamp(mainGame.camera.zoom * (1.0f + 0.1f * wheel), camera_min_zoom, camera_max_zoom);
+    }
+    if (IsKeyPressed(KEY_HOME))
+    {
+        ResetGameCamera();
+    }
+}
+// the side panel and the build buttons eat clicks, the map underneath shouldn't get them
+static bool IsMouseOnUI()
+{
+    Vector2 mouse = GetMousePosition();
+    return mouse.x >= GRID_COLS * TILE_SIZE || (mouse.y >= screenHeight - TILE_SIZE && mouse.x < 3 * TILE_SIZE);
+}
+
+/* the rest of the current wave in one go, nothing drawn in between
+ * steps at a fixed resolve_tick_dt until the wave is over or the player is dead,
+ * then leaves a summary of what happened for the HUD
+ */
+static void ResolveWave()
+{
+    double start = GetTime();
+    int healthBefore = mainGame.player_health;
+    int moneyBefore = mainGame.playerMoney;
+    int killsBefore = mainGame.enemies_killed;
+    int ticks = 0;
+    mainGame.particles.suppressed = true;
+    while (mainGame.wave_manager.IsWaveActive() && mainGame.player_health > 0 && ticks < resolve_max_ticks)
+    {
+        ticks += mainGame.AdvanceSimulation(resolve_tick_dt, resolve_max_ticks - ticks);
+        frame_arena.Reset(); // every tick's lists are gone by now, no need to hold them all until the frame ends
+    }
+    mainGame.particles.suppressed = false;
+    ticksSimulated += ticks;
+    snprintf(resolveSummary, sizeof(resolveSummary), "Resolved %.1f s of wave in %.0f ms: %d kills, %+d health, %+d money", ticks * resolve_tick_dt,
+             (GetTime() - start) * 1000.0, mainGame.enemies_killed - killsBefore, mainGame.player_health - healthBefore, mainGame.playerMoney - moneyBefore);
+    resolveShownAt = GetTime();
+}
+
+// back to tick (GameState::RewindTo), the selected turret pointed into the old entities
+
+static bool RewindTo(unsigned long long tick)
+{
+    if (!mainGame.RewindTo(tick))
+        return false;
+    currentTurret = nullptr;
+    // rewinding out of a lost (or won) game puts it back in play
+    gameOver = false;
+    gameWon = false;
+    statsExported = false;
+    return true;
+}
+
+// this frame's numbers for the metrics endpoint, one pass over the entities
+static void PublishMetrics(double frameStart, double updateStart, double drawStart, double guiStart)
+{
+    float frameTime = GetFrameTime();
+    if (frameTime > 0.0f)
+        ticksPerSecond += (frameTicks / frameTime - ticksPerSecond) * 0.1f;
+    MetricsSnapshot &m = metricsServer.Next();
+    m = MetricsSnapshot();
+    for (auto &entity : mainGame.entities)
+    {
+        if (!entity->IsActive())
+            continue;
+        switch (entity->kind)
+        {
+        case EntityKind::ENEMY:
+            m.enemies[(int)static_cast<Enemy *>(entity.get())->GetEnemyType()]++;
+            break;
+        case EntityKind::TURRET:
+            m.turrets[(int)static_cast<Turret *>(entity.get())->turret]++;
+            break;
+        case EntityKind::PROJECTILE:
+            m.projectiles++;
+            break;
+        }
+    }
+    m.particles = (int)mainGame.particles.particles.size();
+    m.parked = mainGame.parkedCount;
+    m.turretsAwake = mainGame.turretsAwake;
+    double now = GetTime();
+    m.inputMs = (updateStart - frameStart) * 1000.0;
+    m.updateMs = (drawStart - updateStart) * 1000.0;
+    m.drawMs = (guiStart - drawStart) * 1000.0;
+    m.guiMs = (now - guiStart) * 1000.0;
+    m.frameMs = frameTime * 1000.0;
+    m.ticksPerSecond = ticksPerSecond;
+    m.simTick = mainGame.simTick;
+    m.ticksSimulated = ticksSimulated;
+    m.wave = mainGame.wave_manager.GetWaveNumber();
+    m.money = mainGame.playerMoney;
+    m.health = mainGame.player_health;
+    m.kills = mainGame.enemies_killed;
+    metricsServer.Publish();
+}
 
 Scene Game()
 {
+    // turrets built and sold below touch the entities directly, they go by the current game
+    mainGame.MakeCurrent();
+    double frameStart = GetTime();
     if (!initialized)
     {
-        Vector2 screenCenter = {(float)screenWidth / 2, (float)screenHeight / 2};
-        camera.target = screenCenter;
-        camera.offset = screenCenter;
-        camera.rotation = 0.0f;
-        camera.zoom = 1.0f;
+        ResetGameCamera();
         initialized = true;
         current_build = buildState::NONE;
+        // fresh map every game (turret flags from the last one go away too), the built-in one if the file won't load
+        if (!mainGame.LoadMap(map_file))
+        {
+            TraceLog(LOG_WARNING, "MAP: could not load %s, using the built-in map", map_file);
+        }
+        // opened once and kept for the whole session, every new game in it starts with a NEW_GAME event
+        if (telemetry_file && !telemetryLog.IsOpen())
+        {
+            if (telemetryLog.Open(telemetry_file))
+                mainGame.telemetry = &telemetryLog;
+            else
+                TraceLog(LOG_WARNING, "TELEMETRY: could not open %s", telemetry_file);
+        }
+        if (metrics_port > 0 && !metricsServer.IsRunning())
+            metricsServer.Start(metrics_port);
         Turret::LoadTextures();
         Projectile::LoadTextures();
         Enemy::LoadTextures();
+        ParticleSystem::LoadTextures();
     }
 
     // ---- INPUT PASS ----
@@ -55,172 +223,164 @@ Scene Game()
     {
         current_build = buildState::NONE;
     }
-
-    // Spawn turret at mouse (only on buildable tiles)
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+    UpdateGameCamera();
+    // 1..5 pick the game speed, same as clicking the speed button round
+    for (int i = 0; i < SPEED_MODE_COUNT; i++)
     {
-        Vector2 mousePos = GetMousePosition();
-        Tile *tile = gameMap.getTileFromMouse(mousePos);
-
-        if (tile != nullptr && tile->type == TileType::BUILDABLE && !tile->hasTurret && current_build != buildState::NONE)
-        {
-            // Place turret at center of tile
-            Vector2 turretPos = {tile->rect.x + tile->rect.width / 2, tile->rect.y + tile->rect.height / 2};
-            switch (current_build)
-            {
-                case buildState::DUO:
-                {   // Use the global constant for build cost check
-                    if (playerMoney >= duo_turret_cost)
-                    {
-                        entities.push_back(make_unique<duo_turret>(turretPos, tile));
-                        stat_manager.MoneySpent(duo_turret_cost);
-                        tile->hasTurret = true;
-                        playerMoney -= duo_turret_cost; // This was correct, but I'm including it for completeness
-                    }
-                    break;
-                }
-                case buildState::LANCER:
-                {
-                    if (playerMoney >= lancer_turret_cost)
-                    {
-                        entities.push_back(make_unique<lancer_turret>(turretPos, tile));
-                        stat_manager.MoneySpent(lancer_turret_cost);
-                        tile->hasTurret = true;
-                        playerMoney -= lancer_turret_cost; // This was correct, but I'm including it for completeness
-                    }
-                    break;
-                }
-                case buildState::WAVE:
-                {
-                    if (playerMoney >= wave_turret_cost)
-                    {   
-                        entities.push_back(make_unique<wave_turret>(turretPos, tile));
-                        stat_manager.MoneySpent(wave_turret_cost);
-                        tile->hasTurret = true;
-                        playerMoney -= wave_turret_cost; // This was correct, but I'm including it for completeness
-                    }
-                    break;
-                }
-            }
-            
-        }
+        if (IsKeyPressed(KEY_ONE + i))
+            speedMode = i;
     }
-
-    // ------ UPDATE PASS ------
-    if (!gameOver && !gameWon)
+    // F1 shows the debug lines, the debug keys below only do something while they're up
+    if (IsKeyPressed(KEY_F1))
     {
-        // Calling simple Update for all entities
-        for (auto &entity : entities)
-        {
-            entity->Update(GetFrameTime());
-        }
-        particles.Update(GetFrameTime());
+        showDebug = !showDebug;
     }
-    
-    // Separate entities into turrets, enemies, and projectiles
-    vector<Turret *> turret_ptrs;
-    vector<Enemy *> enemy_ptrs;
-    vector<Projectile *> projectile_ptrs;
-    vector<unique_ptr<Entity>> newProjectiles;
-
-    for (auto &entity : entities)
+    if (showDebug)
     {
-        if (!entity->IsActive())
-            continue;
-        if (Turret *t = dynamic_cast<Turret *>(entity.get()))
+        if (IsKeyPressed(KEY_F3))
         {
-            turret_ptrs.push_back(t);
+            mainGame.particles.batched = !mainGame.particles.batched; // for comparing the two particle paths
         }
-        else if (Enemy *e = dynamic_cast<Enemy *>(entity.get()))
+        // quick save / quick load of the whole game state
+        if (IsKeyPressed(KEY_F5))
         {
-            enemy_ptrs.push_back(e);
+            double start = GetTime();
+            mainGame.CatchUpAll();
+            SaveSnapshotFile("quicksave.ozs", mainGame);
+            snapshotMs = (GetTime() - start) * 1000.0;
         }
-        else if (Projectile *p = dynamic_cast<Projectile *>(entity.get()))
+        // navigation mode, only between waves, enemies on the way would be lost switching
+        if (IsKeyPressed(KEY_F6) && !mainGame.wave_manager.IsWaveActive())
         {
-            projectile_ptrs.push_back(p);
+            mainGame.CatchUpAll(); // they were parked by the old way of walking
+            mainGame.nav_mode = mainGame.nav_mode == NavMode::FLOW_FIELD ? NavMode::WAYPOINTS : NavMode::FLOW_FIELD;
+            if (mainGame.nav_mode == NavMode::WAYPOINTS)
+                mainGame.map.BuildWaypoints(); // not kept up to date through edits while the flow field was on
+            mainGame.forceSnapshot = true;
         }
-    }
-
-    // Update turrets with knowledge of enemies
-    if (!gameOver && !gameWon)
-    {
-        for (auto &turret : turret_ptrs)
+        if (IsKeyPressed(KEY_F7))
         {
-            turret->Update(GetFrameTime(), enemy_ptrs, newProjectiles);
+            turret_sleep = !turret_sleep; // for comparing against every turret scanning every tick
         }
-
-        // Update enemy
-        for (auto &enemy : enemy_ptrs)
+        if (IsKeyPressed(KEY_F8))
         {
-            enemy->DoEnemyAction(enemy_ptrs, GetFrameTime());
-            enemy->Update();
+            fast_forward = !fast_forward; // for checking it against full ticks
         }
-        // update wave information
-        wave_manager.Update(GetFrameTime(), entities, enemy_ptrs.size());
-
-        // ---- INTERACTION PASS -----
-        // Projectiles interact with enemies
-        for (auto *projectile : projectile_ptrs)
+        if (IsKeyPressed(KEY_F10))
+        {
+            sim_lod = !sim_lod; // the next tick catches everyone up
+        }
+        if (IsKeyPressed(KEY_H))
+        {
+            showCoverage = !showCoverage;
+        }
+        if (IsKeyPressed(KEY_R))
         {
-            // checking each projectile with each enemy is highly inefficient, but I don't know how to optimise this yet
-            for (auto *enemy : enemy_ptrs)
+            rewindOpen = !rewindOpen;
+            rewindTarget = (float)mainGame.simTick;
+        }
+        if (IsKeyPressed(KEY_F9))
+        {
+            double start = GetTime();
+            if (LoadSnapshotFile("quicksave.ozs", mainGame))
             {
-                if (!enemy->IsActive() || !projectile->IsActive())
-                    continue;
-                /* for collision checking
-                 * we are basically checking if this projectile
-                 * has the enemy_id in it's "currently colliding" stack,
-                 * So as to prevent cases where collisions are detected each frame,
-                 * before the projectile has had a chance to leave the hitbox of
-                 * enemy.
-                 * If they are colliding => check if they have already collided
-                 * else => remove from current_colliding stack;
-                 */
-                bool colliding = CheckCollisionCircles(projectile->GetPosition(), projectile->GetRadius(), enemy->GetPosition(), enemy->GetRadius());
-                if (colliding)
-                {
-                    // New collision this frame
-                    if (projectile->current_colliding.find(enemy->id) == projectile->current_colliding.end())
-                    {
-                        projectile->current_colliding.insert(enemy->id);
-                        projectile->ReducePierceCount();
-                        enemy->TakeDamage(projectile->getProjType(), GetDamageFalloff(1.0f, 0.0f, projectile->enemies_hit));
-                    }
-                }
-                else
-                {
-                    // has collided
-                    projectile->current_colliding.erase(enemy->id);
-                }
+                currentTurret = nullptr; // pointed into the old entities
+                mainGame.forceSnapshot = true;
             }
+            snapshotMs = (GetTime() - start) * 1000.0;
         }
-
-        // --- CLEANUP AND ADDITION PASS ---
-        for (auto &p : newProjectiles)
+    }
+    // mouse in world coordinates, everything on the map uses this
+    Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), mainGame.camera);
+    bool mouseOnUI = IsMouseOnUI();
+
+    /* middle click digs a path tile / fills one in, for trying out mazes
+     * with the flow field enemies on the way just follow the new distances, with waypoints only between waves
+     */
+    if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE) && !mouseOnUI && (mainGame.nav_mode == NavMode::FLOW_FIELD || !mainGame.wave_manager.IsWaveActive()))
+    {
+        Tile *tile = mainGame.map.getTileFromMouse(mouseWorld);
+        if (tile != nullptr && tile->GetType() != TileType::OTHER)
         {
-            entities.push_back(std::move(p));
+            mainGame.CatchUpAll(); // parked enemies have to walk the ticks they missed on the field as it was
+            int index = mainGame.map.IndexOf(tile);
+            if (mainGame.map.SetTileType(index / mainGame.map.cols, index % mainGame.map.cols, tile->GetType() == TileType::PATH ? TileType::BUILDABLE : TileType::PATH))
+                mainGame.forceSnapshot = true;
         }
+    }
+    // Spawn turret at mouse (only on buildable tiles)
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !mouseOnUI)
+    {
+        Vector2 mousePos = mouseWorld;
+        Tile *tile = mainGame.map.getTileFromMouse(mousePos);
 
-        entities.erase(remove_if(entities.begin(), entities.end(), [](const auto &entity) { return !entity->IsActive(); }), entities.end());
+        if (tile != nullptr && current_build != buildState::NONE)
+        {
+            TurretType type = current_build == buildState::DUO ? TurretType::DUO : current_build == buildState::LANCER ? TurretType::LANCER : TurretType::WAVE;
+            if (mainGame.BuildTurret(type, tile))
+                mainGame.forceSnapshot = true;
+        }
     }
 
-    
+    // ------ UPDATE PASS ------
+    double updateStart = GetTime();
+    frameTicks = 0;
+    if (!gameOver && !gameWon && !rewindOpen)
+    {
+        mainGame.particles.Adapt(lastWorkTime);
+        /* sub-stepping, every tick moves the game on by one frame time
+         * at 2x and up as many ticks as the speed asks for, but only while they fit in sim_time_budget,
+         * so a heavy wave makes the game go slower instead of dropping the frame rate (the first tick always runs)
+         */
+        int wanted = SPEED_MODES[speedMode] == 0 ? INT_MAX : SPEED_MODES[speedMode];
+        float dt = GetFrameTime();
+        double start = GetTime();
+        int ticks = 0;
+        mainGame.fastForwardTicks = 0;
+        while (ticks < wanted && mainGame.player_health > 0 && !mainGame.wave_manager.IsFinished())
+        {
+            if (ticks > 0)
+            {
+                if (GetTime() - start >= sim_time_budget)
+                    break;
+                frame_arena.Reset(); // the previous tick's lists are dead already
+            }
+            ticks += mainGame.AdvanceSimulation(dt, wanted - ticks);
+        }
+        effectiveSpeed += (ticks - effectiveSpeed) * 0.1f;
+        frameTicks = ticks;
+        ticksSimulated += ticks;
+    }
 
     // ---- DRAWING ----
+    double drawStart = GetTime();
+    // world rectangle on screen, anything outside of it is skipped
+    Rectangle view = GetCameraView(mainGame.camera, screenWidth, screenHeight);
+    // chunks that changed get redrawn into their textures, has to happen before BeginMode2D
+    mainGame.map.UpdateCache(view);
+    mainGame.CatchUpInView(view);
     ClearBackground(RAYWHITE);
-    BeginMode2D(camera);
+    BeginMode2D(mainGame.camera);
 
     // Draw map
-    gameMap.Draw();
+    mainGame.map.Draw(view, mouseWorld);
+    if (showDebug && showCoverage)
+        mainGame.coverage_map.Draw(view);
     // Draw entities
-    for (auto &entity : entities)
+    for (auto &entity : mainGame.entities)
     {
-        entity->Draw();
+        if (IsInView(view, entity->GetPosition(), entity->GetDrawRadius()))
+        {
+            entity->Draw();
+        }
     }
+    // all the health bars queued by enemies above, in one batch on top of the sprites
+    health_bars.Flush();
     // draw range of turrets if mouseHover
-    for (auto &turret : turret_ptrs)
+    for (auto &entity : mainGame.entities)
     {
-        turret->drawRangeOnHover(GetMousePosition());
+        if (entity->kind == EntityKind::TURRET && entity->IsActive())
+            static_cast<Turret *>(entity.get())->drawRangeOnHover(mouseWorld, view);
     }
     // draw range if current_build is a turret
     if (current_build != buildState::NONE)
@@ -229,24 +389,25 @@ Scene Game()
         {
         case buildState::DUO:
         {
-            DrawCircleLinesV(GetMousePosition(), duo_turret_range, YELLOW);
+            DrawCircleLinesV(mouseWorld, duo_turret_range, YELLOW);
             break;
         }
         case buildState::LANCER:
         {
-            DrawCircleLinesV(GetMousePosition(), lancer_turret_range, YELLOW);
+            DrawCircleLinesV(mouseWorld, lancer_turret_range, YELLOW);
             break;
         }
         case buildState::WAVE:
         {
-            DrawCircleLinesV(GetMousePosition(), wave_turret_range, BLUE);
+            DrawCircleLinesV(mouseWorld, wave_turret_range, BLUE);
             break;
         }
         }
     }
-    particles.Draw();
+    mainGame.particles.Draw(view);
 
     EndMode2D();
+    double guiStart = GetTime();
     // ----- DRAW GUI -----
     Rectangle basic_turret_buttonRect = {0, screenHeight - TILE_SIZE, TILE_SIZE, TILE_SIZE};
     Rectangle laser_turret_buttonRect = {TILE_SIZE, screenHeight - TILE_SIZE, TILE_SIZE, TILE_SIZE};
@@ -269,28 +430,39 @@ Scene Game()
     }
     if (GuiButton(nextWaveButton, "Next wave"))
     {
-        if (wave_manager.CanStartNextWave())
+        if (mainGame.wave_manager.CanStartNextWave())
         {
-            wave_manager.StartNextWave();
+            mainGame.wave_manager.StartNextWave();
+            mainGame.forceSnapshot = true;
         }
     }
+    Rectangle speedButton = {GRID_COLS * TILE_SIZE + 40 + 2 * TILE_SIZE, TILE_SIZE, 2.5f * TILE_SIZE, 0.95f * TILE_SIZE};
+    Rectangle resolveButton = {GRID_COLS * TILE_SIZE + 40 + 2 * TILE_SIZE, 2.05f * TILE_SIZE, 2.5f * TILE_SIZE, 0.95f * TILE_SIZE};
+    Rectangle rewindButton = {GRID_COLS * TILE_SIZE + 40 + 2 * TILE_SIZE, 0.1f * TILE_SIZE, 2.5f * TILE_SIZE, 0.8f * TILE_SIZE};
+    if (GuiButton(speedButton, SPEED_MODES[speedMode] == 0 ? "Speed max" : TextFormat("Speed x%d", SPEED_MODES[speedMode])))
+    {
+        speedMode = (speedMode + 1) % SPEED_MODE_COUNT;
+    }
+    if (GuiButton(resolveButton, "Resolve wave") && mainGame.wave_manager.IsWaveActive() && !gameOver && !gameWon && !rewindOpen)
+    {
+        ResolveWave();
+    }
+    if (GuiButton(rewindButton, "Rewind") && !gameOver && !gameWon)
+    {
+        rewindOpen = !rewindOpen;
+        rewindTarget = (float)mainGame.simTick;
+    }
     /* This block is here and not merged with the input pass because
-    * I wanted to loop through turrets vectors after they have been populated
-    * in the update pass
+    * the click should pick what is drawn this frame, after the update pass
     */
-    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && !mouseOnUI)
     {
-        Vector2 mousePos = GetMousePosition();
-        Tile *tile = gameMap.getTileFromMouse(mousePos);
-        if (tile != nullptr && tile->hasTurret && current_build == buildState::NONE)
+        Vector2 mousePos = mouseWorld;
+        Tile *tile = mainGame.map.getTileFromMouse(mousePos);
+        if (tile != nullptr && tile->HasTurret() && current_build == buildState::NONE)
         {
-            for (auto &turret : turret_ptrs)
-            {
-                if (CheckCollisionPointCircle(mousePos, turret->GetPosition(), turret->radius))
-                {
-                    currentTurret = turret;
-                }
-            }
+            // the tile knows its turret, no need to go through every entity
+            currentTurret = mainGame.map.TurretOn(tile);
         }
     }
 
@@ -310,8 +482,11 @@ Scene Game()
 
     // turret info draw call
     if (currentTurret) {
-        if (currentTurret->DrawTurretInfo(entities))
+        if (currentTurret->DrawTurretInfo(mainGame.entities, mainGame.map))
+        {
             currentTurret = nullptr;
+            mainGame.forceSnapshot = true; // sold or upgraded
+        }
     } else {
         // If no turret is selected, show build info for the turret being placed
         switch (current_build)
@@ -333,14 +508,39 @@ Scene Game()
 
     // -----
     DrawFPS(screenWidth - 80, 10);
-    DrawText(TextFormat("Health : %d", player_health), screenWidth - MeasureText("Health : x      ", 20), screenHeight - 28, 20, RED);
-    DrawText(TextFormat(" : %d", playerMoney), screenWidth - 80, 40, 20, GREEN);
+    // debug lines, F1
+    if (showDebug)
+    {
+        DrawText(TextFormat("Particles: %d (%s) %.2f ms, budget %.0f%%", (int)mainGame.particles.particles.size(), mainGame.particles.batched ? "quads" : "circles", mainGame.particles.last_draw_ms, mainGame.particles.budget * 100.0f), GRID_COLS * TILE_SIZE + 30, screenHeight - 110, 10, DARKGRAY);
+        DrawText(TextFormat("Heap allocs last frame: %s, arena %zu / %zu KB (peak %zu, overflows %d)", HEAP_COUNTING ? TextFormat("%llu", heap_stats.last_frame) : "not counted", frame_arena.last_frame_used / 1024, frame_arena.Capacity() / 1024, frame_arena.peak_used / 1024, frame_arena.last_frame_overflows), GRID_COLS * TILE_SIZE + 30, screenHeight - 98, 10, DARKGRAY);
+        DrawText(TextFormat("F5 save / F9 load: last %.3f ms", snapshotMs), GRID_COLS * TILE_SIZE + 30, screenHeight - 122, 10, DARKGRAY);
+        DrawText(TextFormat("Nav: %s (F6), field update %d tiles", mainGame.nav_mode == NavMode::FLOW_FIELD ? "flow field" : "waypoints", mainGame.flow_field.last_update_cells), GRID_COLS * TILE_SIZE + 30, screenHeight - 158, 10, DARKGRAY);
+        DrawText(TextFormat("Map %dx%d, chunks redrawn %d", mainGame.map.cols, mainGame.map.rows, mainGame.map.chunks_redrawn), GRID_COLS * TILE_SIZE + 30, screenHeight - 170, 10, DARKGRAY);
+        DrawText(TextFormat("Fast-forward (F8) %s: %d ticks last frame", fast_forward ? "on" : "off", mainGame.fastForwardTicks), GRID_COLS * TILE_SIZE + 30, screenHeight - 206, 10, DARKGRAY);
+        DrawText(TextFormat("Sim LOD (F10) %s: %d enemies parked", sim_lod ? "on" : "off", mainGame.parkedCount), GRID_COLS * TILE_SIZE + 30, screenHeight - 218, 10, DARKGRAY);
+        DrawText(TextFormat("Turrets awake: %d / %d (F7 sleeping %s)", mainGame.turretsAwake, mainGame.turretCount, turret_sleep ? "on" : "off"), GRID_COLS * TILE_SIZE + 30, screenHeight - 194, 10, DARKGRAY);
+        // what the tile under the mouse is already covered by, one lookup, so it doubles as a placement preview
+        Tile *hoveredTile = mainGame.map.getTileFromMouse(mouseWorld);
+        if (hoveredTile)
+        {
+            int index = mainGame.map.IndexOf(hoveredTile);
+            DrawText(TextFormat("Coverage (H): %.0f dps, %d slowing here, last update %d tiles", mainGame.coverage_map.DpsAt(index), mainGame.coverage_map.SlowsAt(index), mainGame.coverage_map.last_update_tiles), GRID_COLS * TILE_SIZE + 30, screenHeight - 182, 10, DARKGRAY);
+        }
+        DrawText(TextFormat("R rewind: %d snapshots, %.1f / %d MB", (int)mainGame.rewind_buffer.Count(), mainGame.rewind_buffer.BytesUsed() / (1024.0f * 1024.0f), (int)(mainGame.rewind_buffer.Budget() >> 20)), GRID_COLS * TILE_SIZE + 30, screenHeight - 134, 10, DARKGRAY);
+    }
+    DrawText(TextFormat("Speed: x%.1f actual (1-5 to change)", effectiveSpeed), GRID_COLS * TILE_SIZE + 30, screenHeight - 146, 10, DARKGRAY);
+    if (GetTime() - resolveShownAt < 5.0)
+    {
+        DrawText(resolveSummary, 10, 10, 20, BLACK);
+    }
+    DrawText(TextFormat("Health : %d", mainGame.player_health), screenWidth - MeasureText("Health : x      ", 20), screenHeight - 28, 20, RED);
+    DrawText(TextFormat(" : %d", mainGame.playerMoney), screenWidth - 80, 40, 20, GREEN);
 
     // game win condition
-    if (wave_manager.IsFinished() && !gameWon && !gameOver)
+    if (mainGame.wave_manager.IsFinished() && !gameWon && !gameOver)
     {
         gameWon = true;
-        for_each(entities.begin(), entities.end(), [](unique_ptr<Entity> &e) {
+        for_each(mainGame.entities.begin(), mainGame.entities.end(), [](unique_ptr<Entity> &e) {
             if (dynamic_cast<Enemy*>(e.get())) {
                 e->Destroy();
             }
@@ -349,16 +549,25 @@ Scene Game()
 
 
     // game over condition
-    if (player_health <= 0 && !gameOver)
+    if (mainGame.player_health <= 0 && !gameOver)
     {
         gameOver = true;
-        for_each(entities.begin(), entities.end(), [](unique_ptr<Entity> &e) {
+        for_each(mainGame.entities.begin(), mainGame.entities.end(), [](unique_ptr<Entity> &e) {
             if (dynamic_cast<Enemy*>(e.get())) { // .get() returns the raw pointer 
                 e->Destroy();
             }
         });
     }
 
+    if ((gameOver || gameWon) && !statsExported)
+    {
+        // dump everything the stats manager collected, for looking at after the game
+        mainGame.stat_manager.WaveEnded(); // in case we died mid-wave
+        mainGame.stat_manager.ExportCSV("game_stats.csv");
+        mainGame.stat_manager.ExportJSON("game_stats.json");
+        statsExported = true;
+    }
+
     if (gameOver || gameWon)
     {
         DrawRectangle(0, 0, screenWidth, screenHeight, Fade(BLACK, 0.6f));
@@ -374,10 +583,10 @@ Scene Game()
         int yPos = screenHeight / 2 - 50;
         int xPos = screenWidth / 2 - 150;
         // blit main information in left side 
-        DrawText(TextFormat("Waves Survived: %d", wave_manager.GetWaveNumber() - 1), xPos, yPos, 20, RAYWHITE);
-        DrawText(TextFormat("Total Enemies Killed: %d", enemies_killed), xPos, yPos + 25, 20, RAYWHITE);
-        DrawText(TextFormat("Total Damage Dealt: %llu", stat_manager.total_damage_done), xPos, yPos + 50, 20, RAYWHITE);
-        DrawText(TextFormat("Total Money Spent: %d", stat_manager.total_money_spent), xPos, yPos + 75, 20, RAYWHITE);
+        DrawText(TextFormat("Waves Survived: %d", mainGame.wave_manager.GetWaveNumber() - 1), xPos, yPos, 20, RAYWHITE);
+        DrawText(TextFormat("Total Enemies Killed: %d", mainGame.enemies_killed), xPos, yPos + 25, 20, RAYWHITE);
+        DrawText(TextFormat("Total Damage Dealt: %.0f", mainGame.stat_manager.total_damage_done), xPos, yPos + 50, 20, RAYWHITE);
+        DrawText(TextFormat("Total Money Spent: %d", mainGame.stat_manager.total_money_spent), xPos, yPos + 75, 20, RAYWHITE);
 
         // Kills per enemy type
         xPos += 300;
@@ -385,18 +594,12 @@ Scene Game()
         DrawText("Kills by Type:", xPos, yPos, 20, LIGHTGRAY);
         yPos += 25;
         // blit auxilliary information on right side
-        for (auto const& [type, count] : stat_manager.enemies_killed_by_type)
+        for (int type = 0; type < ENEMY_TYPE_COUNT; type++)
         {
-            std::string typeName;
-            switch(type) {
-                case EnemyType::FLARE: typeName = "Flare"; break;
-                case EnemyType::MONO: typeName = "Mono"; break;
-                case EnemyType::CRAWLER: typeName = "Crawler"; break;
-                case EnemyType::POLY: typeName = "Poly"; break;
-                case EnemyType::LOCUS: typeName = "Locus"; break;
-                case EnemyType::ANTUMBRA: typeName = "Antumbra"; break;
-            }
-            DrawText(TextFormat("- %s: %d", typeName.c_str(), count), xPos, yPos, 20, RAYWHITE);
+            int count = mainGame.stat_manager.enemies_killed_by_type[type];
+            if (count == 0)
+                continue; // only list what was actually killed
+            DrawText(TextFormat("- %s: %d", StatsManager::EnemyName((EnemyType)type), count), xPos, yPos, 20, RAYWHITE);
             yPos += 25;
         }
 
@@ -406,26 +609,49 @@ Scene Game()
             initialized = false; // Reset game state for next time
             gameWon = false;
             gameOver = false; 
-            entities.clear(); // raw pointers invalid now
-            particles.cleanup();
-            player_health = 10;
-            playerMoney = 250;
-            wave_manager.reset();
-            stat_manager.reset();
-            enemies_killed = 0;
+            statsExported = false;
+            currentTurret = nullptr;
+            mainGame.NewGame(); // raw pointers into the entities are invalid now
+            rewindOpen = false;
             return Scene::INTRO;
         }
     }
 
+    // rewind panel, pick a tick on the slider and go back to it
+    if (rewindOpen)
+    {
+        Rectangle panel = {(float)GRID_COLS * TILE_SIZE / 2 - 250, 20, 500, 90};
+        DrawRectangleRec(panel, Fade(LIGHTGRAY, 0.9f));
+        DrawRectangleLinesEx(panel, 1, DARKGRAY);
+        float oldest = (float)mainGame.rewind_buffer.OldestTick();
+        float now = (float)mainGame.simTick;
+        // 60 ticks a second is only a guess for the label, dts vary
+        DrawText(TextFormat("REWIND (paused)  -%.1f s", (now - rewindTarget) / 60.0f), panel.x + 10, panel.y + 8, 20, BLACK);
+        GuiSliderBar({panel.x + 60, panel.y + 36, 380, 20}, TextFormat("-%.0fs", (now - oldest) / 60.0f), "now", &rewindTarget, oldest, now);
+        if (GuiButton({panel.x + 10, panel.y + 62, 235, 22}, "Rewind here"))
+        {
+            RewindTo((unsigned long long)rewindTarget);
+            rewindOpen = false;
+        }
+        if (GuiButton({panel.x + 255, panel.y + 62, 235, 22}, "Cancel"))
+        {
+            rewindOpen = false;
+        }
+    }
+
     // wave counter
-    DrawText(TextFormat("Wave: %d / %d", wave_manager.GetWaveNumber(), wave_manager.GetTotalWaves()), GRID_COLS * TILE_SIZE + 30, screenHeight - 80, 20, BLACK);
-    DrawText(TextFormat("Stage: %d", wave_manager.GetStageNumber()), GRID_COLS * TILE_SIZE + 30, screenHeight - 50, 20, BLACK);
+    DrawText(TextFormat("Wave: %d / %d", mainGame.wave_manager.GetWaveNumber(), mainGame.wave_manager.GetTotalWaves()), GRID_COLS * TILE_SIZE + 30, screenHeight - 80, 20, BLACK);
+    DrawText(TextFormat("Stage: %d", mainGame.wave_manager.GetStageNumber()), GRID_COLS * TILE_SIZE + 30, screenHeight - 50, 20, BLACK);
 
-    if (!wave_manager.IsFinished())
+    if (!mainGame.wave_manager.IsFinished())
     {
-        DrawText(TextFormat("Boss in: %d", wave_manager.GetWavesUntilBoss()), GRID_COLS * TILE_SIZE + 30, screenHeight - 30, 20, MAROON);
+        DrawText(TextFormat("Boss in: %d", mainGame.wave_manager.GetWavesUntilBoss()), GRID_COLS * TILE_SIZE + 30, screenHeight - 30, 20, MAROON);
     }
 
+    if (metricsServer.IsRunning())
+        PublishMetrics(frameStart, updateStart, drawStart, guiStart);
+
+    lastWorkTime = (float)(GetTime() - frameStart);
     return Scene::GAME;
 }
 /* I recognise the use of magic numbers and the potential harms that come with it.
@@ -19,19 +19,22 @@ Settings()
   static bool fullscreenFlag = false;
 
   Rectangle set1 = {
-    (float)screenWidth / 2 - 100, (float)screenHeight / 2 - 125, 200, 75
+    (float)screenWidth / 2 - 100, (float)screenHeight / 2 - 175, 200, 75
   };
   Rectangle set2 = {
-    (float)screenWidth / 2 - 150, (float)screenHeight / 2 - 125, 50, 75
+    (float)screenWidth / 2 - 150, (float)screenHeight / 2 - 175, 50, 75
   };
   Rectangle set3 = {
-    (float)screenWidth / 2 + 100, (float)screenHeight / 2 - 125, 50, 75
+    (float)screenWidth / 2 + 100, (float)screenHeight / 2 - 175, 50, 75
   };
   Rectangle full = {
-    (float)screenWidth / 2 - 150, (float)screenHeight / 2 , 300, 75
+    (float)screenWidth / 2 - 150, (float)screenHeight / 2 - 75, 300, 75
+  };
+  Rectangle bars = {
+    (float)screenWidth / 2 - 150, (float)screenHeight / 2 + 25, 300, 75
   };
   Rectangle back = {
-    (float)screenWidth / 2 - 150, (float)screenHeight / 2 + 100, 300, 75
+    (float)screenWidth / 2 - 150, (float)screenHeight / 2 + 125, 300, 75
   };
 
   if (CheckCollisionPointRec(GetMousePosition(), set2)) {
@@ -72,6 +75,13 @@ Settings()
     }
   }
 
+  // health bars on every enemy, or only on damaged ones
+  if (CheckCollisionPointRec(GetMousePosition(), bars)) {
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+      health_bars.always_show = !health_bars.always_show;
+    }
+  }
+
   if (CheckCollisionPointRec(GetMousePosition(), back)) {
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
       return Scene::INTRO;
@@ -83,6 +93,7 @@ Settings()
   DrawRectangleRec(set2, RED);
   DrawRectangleRec(set3, GREEN);
   DrawRectangleRec(full, YELLOW);
+  DrawRectangleRec(bars, ORANGE);
   DrawRectangleRec(back, BLUE);
 
   DrawText("+",
@@ -105,6 +116,12 @@ Settings()
            full.y + full.height / 2 - 10,
            30,
            DARKGRAY);
+  const char *barsText = health_bars.always_show ? "Health bars: always" : "Health bars: damaged";
+  DrawText(barsText,
+           bars.x + bars.width / 2 - MeasureText(barsText, 25) / 2,
+           bars.y + bars.height / 2 - 10,
+           25,
+           DARKGRAY);
   DrawText("Back",
            back.x + back.width / 2 - MeasureText("Back", 30) / 2,
            back.y + back.height / 2 - 10,
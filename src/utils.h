@@ -53,17 +53,20 @@ inline float normaliseAngle(float angle)
     return angle;
 }
 
-// helper function to draw health bar on top of any entity,
-// seperated and kept here to make code scaleable and this functionality reusable
-inline void DrawHealthBar(float curr_health, float max_health, Vector2 entity_pos)
+/* Culling helpers
+ * view => the part of the world the camera currently sees (world coordinates)
+ * anything that doesn't touch it doesn't need a draw call
+ */
+inline Rectangle GetCameraView(const Camera2D &camera, int width, int height)
 {
-    float bar_thickness = 5.0f;
-    float bar_width = 20.0f;
-    Rectangle healthBar = {entity_pos.x - bar_width / 2, entity_pos.y - bar_thickness * 4, bar_width, bar_thickness};
-    Rectangle currHealth = {entity_pos.x - bar_width / 2, entity_pos.y - bar_thickness * 4, bar_width * curr_health / max_health, bar_thickness};
-
-    DrawRectangleRec(healthBar, GRAY);
-    DrawRectangleRec(currHealth, RED);
+    Vector2 topLeft = GetScreenToWorld2D({0, 0}, camera);
+    Vector2 bottomRight = GetScreenToWorld2D({(float)width, (float)height}, camera);
+    return {topLeft.x, topLeft.y, bottomRight.x - topLeft.x, bottomRight.y - topLeft.y};
+}
+// pos is visible if a circle of this radius around it touches the view
+inline bool IsInView(const Rectangle &view, Vector2 pos, float radius)
+{
+    return pos.x + radius >= view.x && pos.x - radius <= view.x + view.width && pos.y + radius >= view.y && pos.y - radius <= view.y + view.height;
 }
 
 /* Calculate damage falloff based off of how far enemy is
@@ -0,0 +1,144 @@
+/* batch_run : plays lots of games headless, spread over every core, for balance checks
+ * Every run is a fresh game on the same map with its own seed, following one build order
+ * (format in batch_sim.h). One GameState per worker thread, reused between runs (NewGame),
+ * the wave scripts and the build order are loaded once and shared read-only by all of them.
+ *
+ * Writes one CSV line per run (to --out or stdout): waves survived, health lost per wave,
+ * damage per turret type, and runs per second at the end on stderr.
+ * For sweeps over many maps / build orders that run for hours, see scenario_farm.
+ *
+ * --telemetry prefix logs every game's events (Telemetry.h), one log per thread: prefix.<thread>.oztl,
+ * each run in it starts with its NEW_GAME event (id = seed).
+ *
+ * make batch && ./build/batch_run maps/default.ozm builds/example.ozb [--runs N] [--seed S] [--threads N] [--waves file.ozw] [--out file.csv] [--telemetry prefix]
+ */
+#include "batch_sim.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <map.ozm> <build.ozb> [--runs N] [--seed S] [--threads N] [--waves file.ozw] [--out file.csv]\n", argv[0]);
+        return 1;
+    }
+    const char *mapPath = argv[1];
+    const char *buildPath = argv[2];
+    int runs = 1000;
+    unsigned int firstSeed = 1;
+    int threads = (int)thread::hardware_concurrency();
+    const char *wavesPath = nullptr;
+    const char *outPath = nullptr;
+    const char *telemetryPrefix = nullptr;
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--runs"))
+            runs = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed"))
+            firstSeed = (unsigned int)strtoul(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads"))
+            threads = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--waves"))
+            wavesPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--out"))
+            outPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--telemetry"))
+            telemetryPrefix = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (threads < 1)
+        threads = 1;
+    if (runs < 0)
+        runs = 0;
+
+    // loaded once here, every game only reads them
+    string error;
+    vector<BuildStep> steps;
+    if (!LoadBuildOrder(buildPath, steps, error))
+    {
+        fprintf(stderr, "%s: %s\n", buildPath, error.c_str());
+        return 1;
+    }
+    shared_ptr<const WaveScripts> waves = WaveManager::DefaultScripts();
+    if (wavesPath && !(waves = WaveManager::LoadScripts(wavesPath, error)))
+    {
+        fprintf(stderr, "%s: %s\n", wavesPath, error.c_str());
+        return 1;
+    }
+    {
+        // checked once up front, so a typo doesn't quietly become a thousand games on the built-in map
+        GameState probe;
+        if (!probe.LoadMap(mapPath))
+        {
+            fprintf(stderr, "%s: can't load map\n", mapPath);
+            return 1;
+        }
+    }
+
+    vector<RunResult> results(runs);
+    atomic<int> nextRun{0};
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    atomic<unsigned long long> telemetryDropped{0};
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            // big (the rewind buffer, the tile cache bookkeeping), so on the heap, and only one per thread
+            auto state = make_unique<GameState>();
+            PrepareGame(*state, mapPath, waves);
+            // one producer per log, so every thread gets its own
+            TelemetryLog log;
+            if (telemetryPrefix && log.Open((string(telemetryPrefix) + "." + to_string(t) + ".oztl").c_str()))
+                state->telemetry = &log;
+            for (int run = nextRun++; run < runs; run = nextRun++)
+                PlayOne(*state, steps, firstSeed + (unsigned int)run, results[run]);
+            state->telemetry = nullptr;
+            telemetryDropped += log.Dropped();
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "%s: can't write\n", outPath);
+        return 1;
+    }
+    fprintf(out, "run,");
+    WriteResultHeader(out);
+    fprintf(out, "\n");
+    int won = 0;
+    long long wavesTotal = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        const RunResult &r = results[run];
+        won += !strcmp(r.outcome, "won");
+        wavesTotal += r.wavesSurvived;
+        fprintf(out, "%d,", run);
+        WriteResult(out, r);
+        fprintf(out, "\n");
+    }
+    if (out != stdout)
+        fclose(out);
+
+    fprintf(stderr, "%d runs on %d threads in %.2f s, %.1f runs/s, %d won, %.2f waves survived on average\n", runs, threads, seconds, seconds > 0 ? runs / seconds : 0.0, won,
+            runs > 0 ? (double)wavesTotal / runs : 0.0);
+    if (telemetryDropped > 0)
+        fprintf(stderr, "telemetry: %llu events dropped, the writers couldn't keep up\n", telemetryDropped.load());
+    return 0;
+}
@@ -0,0 +1,220 @@
+/* batch_sim.h : one headless game at a time, shared by batch_run and scenario_farm
+ * A game follows a build order and starts every wave as soon as the last one is over,
+ * ticking at resolve_tick_dt like an instant resolve.
+ *
+ * Build order file (.ozb), plain text, steps run top to bottom:
+ *   # comment
+ *   wave <n> build <row> <col> <duo|lancer|wave>     once wave n is up (before it starts)
+ *   wave <n> upgrade <row> <col>                     next tier of whatever is on that tile
+ *   at <seconds> sell <row> <col>                    or after that much game time instead of a wave
+ * A step waits for its wave / time and then for the money, and every step after it waits too.
+ * Steps that can't ever happen (nothing to upgrade, tile taken, last tier) are skipped and counted.
+ */
+#pragma once
+#include "Config.h"
+#include "GameState.h"
+#include "StatsManager.h"
+#include "Turret.h"
+#include "Wave.h"
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+enum class StepAction
+{
+    BUILD,
+    UPGRADE,
+    SELL
+};
+
+struct BuildStep
+{
+    int wave = 0;          // 1-indexed, 0 = doesn't wait for a wave
+    float seconds = 0.0f;  // game time, for "at" steps
+    StepAction action;
+    int row = 0;
+    int col = 0;
+    TurretType type = TurretType::DUO; // BUILD only
+};
+
+struct RunResult
+{
+    unsigned int seed = 0;
+    const char *outcome = "timeout"; // won, lost or timeout
+    int wavesSurvived = 0;
+    int health = 0;
+    int money = 0;
+    int kills = 0;
+    unsigned long long ticks = 0;
+    int skippedSteps = 0;
+    vector<int> leaks; // health lost in every wave that was played
+    double damage[TURRET_TYPE_COUNT] = {};
+};
+
+inline bool LoadBuildOrder(const char *path, vector<BuildStep> &steps, string &error)
+{
+    ifstream file(path);
+    if (!file)
+    {
+        error = "can't open file";
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        lineNumber++;
+        istringstream in(line);
+        string when, action;
+        if (!(in >> when) || when[0] == '#')
+            continue;
+        BuildStep step;
+        bool ok = false;
+        if (when == "wave")
+            ok = (bool)(in >> step.wave) && step.wave > 0;
+        else if (when == "at")
+            ok = (bool)(in >> step.seconds) && step.seconds >= 0.0f;
+        ok = ok && in >> action >> step.row >> step.col;
+        if (ok && action == "build")
+        {
+            step.action = StepAction::BUILD;
+            string type;
+            ok = (bool)(in >> type);
+            // only the first tiers can be built straight away, the rest come from upgrades
+            if (type == "duo")
+                step.type = TurretType::DUO;
+            else if (type == "lancer")
+                step.type = TurretType::LANCER;
+            else if (type == "wave")
+                step.type = TurretType::WAVE;
+            else
+                ok = false;
+        }
+        else if (ok && action == "upgrade")
+            step.action = StepAction::UPGRADE;
+        else if (ok && action == "sell")
+            step.action = StepAction::SELL;
+        else
+            ok = false;
+        if (!ok)
+        {
+            error = "line " + to_string(lineNumber) + ": expected wave <n> | at <seconds>, then build <row> <col> <type>, upgrade <row> <col> or sell <row> <col>";
+            return false;
+        }
+        steps.push_back(step);
+    }
+    return true;
+}
+
+// every step that's due and paid for, stops at the first one that still has to wait
+inline void RunSteps(GameState &state, const vector<BuildStep> &steps, size_t &next, int &skipped)
+{
+    state.MakeCurrent(); // Upgrade / Sell go through game
+    float seconds = state.simTick * resolve_tick_dt;
+    while (next < steps.size())
+    {
+        const BuildStep &step = steps[next];
+        if (step.wave > state.wave_manager.GetWaveNumber() || step.seconds > seconds)
+            return;
+        Map &map = state.map;
+        Turret *turret = nullptr;
+        bool possible = step.row >= 0 && step.row < map.rows && step.col >= 0 && step.col < map.cols;
+        if (possible)
+        {
+            Tile *tile = &map.at(step.row, step.col);
+            turret = map.TurretOn(tile);
+            switch (step.action)
+            {
+            case StepAction::BUILD:
+                possible = tile->GetType() == TileType::BUILDABLE && !tile->HasTurret();
+                if (possible && !state.BuildTurret(step.type, tile))
+                    return; // not enough money yet
+                break;
+            case StepAction::UPGRADE:
+                possible = turret != nullptr && Turret::NextTier(turret->turret) != turret->turret;
+                if (possible && !turret->Upgrade(state.entities, map))
+                    return;
+                break;
+            case StepAction::SELL:
+                possible = turret != nullptr;
+                if (possible)
+                    turret->Sell(map);
+                break;
+            }
+        }
+        if (!possible)
+            skipped++;
+        next++;
+    }
+}
+
+inline void PlayOne(GameState &state, const vector<BuildStep> &steps, unsigned int seed, RunResult &result)
+{
+    state.NewGame(seed);
+    result.seed = seed;
+    size_t nextStep = 0;
+    int ticks = 0;
+    while (!state.wave_manager.IsFinished() && state.player_health > 0 && ticks < resolve_max_ticks * state.wave_manager.GetTotalWaves())
+    {
+        RunSteps(state, steps, nextStep, result.skippedSteps);
+        if (state.wave_manager.CanStartNextWave())
+        {
+            state.wave_manager.StartNextWave();
+            result.leaks.push_back(0);
+        }
+        int health = state.player_health;
+        ticks += state.AdvanceSimulation(resolve_tick_dt, INT_MAX);
+        frame_arena.Reset();
+        if (!result.leaks.empty())
+            result.leaks.back() += health - state.player_health;
+    }
+    // the wave that got the player isn't survived, even if its last enemy ended it
+    result.wavesSurvived = state.wave_manager.GetWaveNumber() - 1;
+    if (state.wave_manager.IsFinished() && state.player_health > 0)
+    {
+        result.outcome = "won";
+        result.wavesSurvived = state.wave_manager.GetTotalWaves();
+    }
+    else if (state.player_health <= 0)
+    {
+        result.outcome = "lost";
+        result.wavesSurvived = (int)result.leaks.size() - 1;
+    }
+    result.health = state.player_health;
+    result.money = state.playerMoney;
+    result.kills = state.enemies_killed;
+    result.ticks = state.simTick;
+    for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+        result.damage[i] = state.stat_manager.damage_by_turret[i];
+}
+
+// a game ready for PlayOne: map loaded, waves set, nothing drawn or kept for rewind
+inline bool PrepareGame(GameState &state, const char *mapPath, shared_ptr<const WaveScripts> waves)
+{
+    bool loaded = state.LoadMap(mapPath);
+    state.wave_manager.SetScripts(std::move(waves));
+    state.particles.suppressed = true;
+    state.record_rewind = false;
+    return loaded;
+}
+
+// CSV columns of one result, leaks as one field wave by wave so the column count doesn't depend on the wave set
+inline void WriteResultHeader(FILE *out)
+{
+    fprintf(out, "seed,outcome,waves_survived,health,money,kills,ticks,skipped_steps,leaks_per_wave");
+    for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+        fprintf(out, ",damage_%s", StatsManager::TurretName((TurretType)i));
+}
+inline void WriteResult(FILE *out, const RunResult &r)
+{
+    fprintf(out, "%u,%s,%d,%d,%d,%d,%llu,%d,", r.seed, r.outcome, r.wavesSurvived, r.health, r.money, r.kills, r.ticks, r.skippedSteps);
+    for (size_t w = 0; w < r.leaks.size(); w++)
+        fprintf(out, "%s%d", w ? ";" : "", r.leaks[w]);
+    for (int i = 0; i < TURRET_TYPE_COUNT; i++)
+        fprintf(out, ",%.1f", r.damage[i]);
+}
@@ -0,0 +1,279 @@
+/* bench_world : old entity layout vs kind tags + EnemyTable, and the movement / collision systems on the component tables
+ * Builds 50k enemies (and some turrets/projectiles) two ways and times one tick of
+ * partitioning, turret targeting and projectile collision for each.
+ * The "old" side mimics what Game.cpp used to do: dynamic_cast to sort entities,
+ * then every check reads the enemy through its pointer, and every entity moves itself in a virtual Update(dt).
+ * Then the same counts as real Enemy / Projectile objects in a GameState, timed through MoveEnemies, MoveProjectiles
+ * and CollideProjectiles (Systems.cpp) the way SimulateTick runs them.
+ *
+ * make bench && ./build/bench_world [enemies] [ticks]
+ */
+#include "Enemy.h"
+#include "EnemyTable.h"
+#include "GameState.h"
+#include "Projectile.h"
+#include "Systems.h"
+#include "Types.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+using namespace std;
+
+// stand-ins for the real classes, same shape: virtual base, data spread over separate allocations
+struct BenchEntity
+{
+    virtual ~BenchEntity() {}
+    virtual void Update(float dt)
+    {
+        position.x += velocity.x * dt;
+        position.y += velocity.y * dt;
+    }
+    Vector2 position;
+    Vector2 velocity = {0, 0};
+    bool is_active = true;
+};
+struct BenchEnemy : BenchEntity
+{
+    float radius = 10.0f;
+    bool isVisible = true;
+    bool slowed = false;
+    float hp = 100.0f;
+};
+struct BenchTurret : BenchEntity
+{
+    float range = 192.0f;
+};
+struct BenchProjectile : BenchEntity
+{
+    float radius = 3.0f;
+};
+
+static double Seconds(chrono::steady_clock::time_point a, chrono::steady_clock::time_point b)
+{
+    return chrono::duration<double>(b - a).count();
+}
+
+int main(int argc, char **argv)
+{
+    int enemyCount = argc > 1 ? atoi(argv[1]) : 50000;
+    int ticks = argc > 2 ? atoi(argv[2]) : 20;
+    const int turretCount = 200;
+    const int projectileCount = 2000;
+    const float worldW = 1280.0f, worldH = 1280.0f;
+
+    mt19937 rng(1234);
+    uniform_real_distribution<float> rx(0.0f, worldW), ry(0.0f, worldH);
+    uniform_real_distribution<float> rv(-90.0f, 90.0f); // about flare speed
+    const float dt = 1.0f / 60.0f;
+
+    // interleaved like entities is in practice: turrets first, then enemies and projectiles as they spawn
+    vector<unique_ptr<BenchEntity>> entities;
+    for (int i = 0; i < turretCount; i++)
+    {
+        auto t = make_unique<BenchTurret>();
+        t->position = {rx(rng), ry(rng)};
+        entities.push_back(std::move(t));
+    }
+    for (int i = 0; i < enemyCount; i++)
+    {
+        auto e = make_unique<BenchEnemy>();
+        e->position = {rx(rng), ry(rng)};
+        e->velocity = {rv(rng), rv(rng)};
+        e->isVisible = (i % 7) != 0;
+        entities.push_back(std::move(e));
+        if (i % (enemyCount / projectileCount + 1) == 0)
+        {
+            auto p = make_unique<BenchProjectile>();
+            p->position = {rx(rng), ry(rng)};
+            p->velocity = {4.0f * rv(rng), 4.0f * rv(rng)};
+            entities.push_back(std::move(p));
+        }
+    }
+    // kind tags for the new path, what Entity::kind holds in the game
+    vector<EntityKind> kinds;
+    for (auto &e : entities)
+    {
+        if (dynamic_cast<BenchTurret *>(e.get()))
+            kinds.push_back(EntityKind::TURRET);
+        else if (dynamic_cast<BenchEnemy *>(e.get()))
+            kinds.push_back(EntityKind::ENEMY);
+        else
+            kinds.push_back(EntityKind::PROJECTILE);
+    }
+
+    long long checksumOld = 0, checksumNew = 0; // both paths must find the same things
+    double oldMove = 0, oldPartition = 0, oldTarget = 0, oldCollide = 0;
+    double newPartition = 0, newTarget = 0, newCollide = 0;
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        // ---- old ----
+        auto tm = chrono::steady_clock::now();
+        for (auto &e : entities)
+        {
+            e->Update(dt);
+        }
+        auto t0 = chrono::steady_clock::now();
+        vector<BenchTurret *> turrets;
+        vector<BenchEnemy *> enemies;
+        vector<BenchProjectile *> projectiles;
+        for (auto &e : entities)
+        {
+            if (auto *t = dynamic_cast<BenchTurret *>(e.get()))
+                turrets.push_back(t);
+            else if (auto *en = dynamic_cast<BenchEnemy *>(e.get()))
+                enemies.push_back(en);
+            else if (auto *p = dynamic_cast<BenchProjectile *>(e.get()))
+                projectiles.push_back(p);
+        }
+        auto t1 = chrono::steady_clock::now();
+        for (auto *t : turrets)
+        {
+            BenchEnemy *target = nullptr;
+            float closest = 999999.0f;
+            for (auto *e : enemies)
+            {
+                if (!e->isVisible)
+                    continue;
+                float dx = e->position.x - t->position.x, dy = e->position.y - t->position.y;
+                float dist = sqrtf(dx * dx + dy * dy);
+                if (dist < t->range && dist < closest)
+                {
+                    closest = dist;
+                    target = e;
+                }
+            }
+            checksumOld += target ? (long long)(target->position.x) : -1;
+        }
+        auto t2 = chrono::steady_clock::now();
+        for (auto *p : projectiles)
+        {
+            for (auto *e : enemies)
+            {
+                float dx = e->position.x - p->position.x, dy = e->position.y - p->position.y;
+                float dist = sqrtf(dx * dx + dy * dy);
+                if (dist <= e->radius + p->radius)
+                    checksumOld++;
+            }
+        }
+        auto t3 = chrono::steady_clock::now();
+        oldMove += Seconds(tm, t0);
+        oldPartition += Seconds(t0, t1);
+        oldTarget += Seconds(t1, t2);
+        oldCollide += Seconds(t2, t3);
+
+        // ---- new ----
+        t0 = chrono::steady_clock::now();
+        vector<BenchTurret *> turrets2;
+        vector<BenchProjectile *> projectiles2;
+        EnemyTable table;
+        table.reserve(enemyCount);
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            switch (kinds[i])
+            {
+            case EntityKind::TURRET:
+                turrets2.push_back(static_cast<BenchTurret *>(entities[i].get()));
+                break;
+            case EntityKind::ENEMY:
+            {
+                auto *e = static_cast<BenchEnemy *>(entities[i].get());
+                table.Add(nullptr, e->position, e->radius, e->isVisible, e->slowed, -1); // no map in the bench
+                break;
+            }
+            case EntityKind::PROJECTILE:
+                projectiles2.push_back(static_cast<BenchProjectile *>(entities[i].get()));
+                break;
+            }
+        }
+        t1 = chrono::steady_clock::now();
+        for (auto *t : turrets2)
+        {
+            int i = table.FindClosest(t->position, t->range, false, false);
+            checksumNew += i >= 0 ? (long long)(table.x[i]) : -1;
+        }
+        t2 = chrono::steady_clock::now();
+        for (auto *p : projectiles2)
+        {
+            for (size_t i = 0; i < table.size(); i++)
+            {
+                if (table.Overlaps(i, p->position, p->radius))
+                    checksumNew++;
+            }
+        }
+        t3 = chrono::steady_clock::now();
+        newPartition += Seconds(t0, t1);
+        newTarget += Seconds(t1, t2);
+        newCollide += Seconds(t2, t3);
+    }
+
+    // ---- systems, on real enemies and projectiles ----
+    // flares and duo bullets on the built-in map, spread over it and moving about as fast as they do in a game
+    auto world = make_unique<GameState>();
+    world->MakeCurrent();
+    world->NewGame();
+    Rectangle bounds = world->map_bounds;
+    uniform_real_distribution<float> wx(bounds.x, bounds.x + bounds.width), wy(bounds.y, bounds.y + bounds.height);
+    for (int i = 0; i < enemyCount; i++)
+    {
+        auto e = make_unique<flare_enemy>();
+        e->SetPosition({wx(rng), wy(rng)});
+        e->SetVelocity({rv(rng), rv(rng)});
+        world->entities.push_back(std::move(e));
+    }
+    vector<Projectile *> bullets;
+    for (int i = 0; i < projectileCount; i++)
+    {
+        auto p = make_unique<normal_bullet>(Vector2{wx(rng), wy(rng)}, Vector2{wx(rng), wy(rng)});
+        bullets.push_back(p.get());
+        world->entities.push_back(std::move(p));
+    }
+    double bodiesMove = 0, bodiesPartition = 0, bodiesCollide = 0;
+    size_t hits = 0;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        auto t0 = chrono::steady_clock::now();
+        MoveEnemies(world->enemy_bodies, bounds, dt);
+        MoveProjectiles(world->projectile_bodies, dt);
+        auto t1 = chrono::steady_clock::now();
+        world->enemy_bodies.MarkInPlay();
+        world->projectile_bodies.MarkInPlay();
+        auto t2 = chrono::steady_clock::now();
+        CollideProjectiles(world->projectile_bodies, world->enemy_bodies);
+        auto t3 = chrono::steady_clock::now();
+        hits += world->damage_events.events.size();
+        world->damage_events.clear();
+        frame_arena.Reset();
+        // in a crowd this thick every bullet hits on the first tick, back into play so every tick checks all of them like the other two
+        for (auto *p : bullets)
+        {
+            p->is_active = true;
+            world->projectile_bodies.SetFlag(p->body, BODY_ACTIVE, true);
+            p->pierce_count = 1;
+            p->enemies_hit = 0;
+            p->current_colliding.clear();
+        }
+        bodiesMove += Seconds(t0, t1);
+        bodiesPartition += Seconds(t1, t2);
+        bodiesCollide += Seconds(t2, t3);
+    }
+
+    printf("%d enemies, %d turrets, %d projectiles, %d ticks (ms per tick)\n", enemyCount, turretCount, projectileCount, ticks);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "", "movement", "partition", "targeting", "collision", "total");
+    printf("%-10s %10.3f %10.3f %10.3f %10.3f %10.3f\n", "old", oldMove * 1000 / ticks, oldPartition * 1000 / ticks, oldTarget * 1000 / ticks, oldCollide * 1000 / ticks,
+           (oldMove + oldPartition + oldTarget + oldCollide) * 1000 / ticks);
+    printf("%-10s %10s %10.3f %10.3f %10.3f %10.3f\n", "table", "-", newPartition * 1000 / ticks, newTarget * 1000 / ticks, newCollide * 1000 / ticks, (newPartition + newTarget + newCollide) * 1000 / ticks);
+    // swept, so it does more per pair than the plain overlap tests above, and the hits aren't the same ones
+    printf("%-10s %10.3f %10.3f %10s %10.3f %10.3f   (swept, %zu hits)\n", "bodies", bodiesMove * 1000 / ticks, bodiesPartition * 1000 / ticks, "-", bodiesCollide * 1000 / ticks,
+           (bodiesMove + bodiesPartition + bodiesCollide) * 1000 / ticks, hits);
+    if (checksumOld != checksumNew)
+    {
+        printf("MISMATCH: old %lld, table %lld\n", checksumOld, checksumNew);
+        return 1;
+    }
+    return 0;
+}
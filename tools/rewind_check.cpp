@@ -0,0 +1,111 @@
+/* rewind_check : plays a headless game with the rewind buffer on and checks that rewinding lands
+ * on exactly the state the game had at that tick (same snapshot bytes as the first time through).
+ * Rewinds onto a tick that has a snapshot of its own, plays on from there (which pushes that tick again),
+ * then rewinds a second time into the ticks before it, which have to replay with their logged dts.
+ *
+ * make check    (runs it on maps/default.ozm with builds/example.ozb, exit code 1 if anything differs)
+ * ./build/rewind_check maps/default.ozm builds/example.ozb [seed]
+ */
+#include "Snapshot.h"
+#include "batch_sim.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+using namespace std;
+
+// not all the same, so a tick replayed with the wrong dt (or none) shows up
+static float DtFor(unsigned long long tick) { return resolve_tick_dt * (1.0f + (tick % 7) * 0.02f); }
+
+static vector<unsigned char> StateBytes(GameState &state)
+{
+    state.CatchUpAll();
+    BinaryWriter out;
+    SaveSnapshot(out, state);
+    return out.data;
+}
+
+// one tick the way the game does it, player actions force a snapshot before the tick
+static void Step(GameState &state, const vector<BuildStep> &steps, size_t &next, int &skipped)
+{
+    size_t before = next;
+    RunSteps(state, steps, next, skipped);
+    if (state.wave_manager.CanStartNextWave())
+    {
+        state.wave_manager.StartNextWave();
+        state.forceSnapshot = true;
+    }
+    if (next != before)
+        state.forceSnapshot = true;
+    state.StepSimulation(DtFor(state.simTick));
+    frame_arena.Reset();
+}
+
+static bool Check(GameState &state, unsigned long long tick, const map<unsigned long long, vector<unsigned char>> &reference, const char *what)
+{
+    bool same = state.simTick == tick && StateBytes(state) == reference.at(tick);
+    printf("%s tick %llu: %s\n", what, tick, same ? "ok" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <map.ozm> <build.ozb> [seed]\n", argv[0]);
+        return 1;
+    }
+    unsigned int seed = argc > 3 ? (unsigned int)strtoul(argv[3], nullptr, 10) : 1;
+    string error;
+    vector<BuildStep> steps;
+    if (!LoadBuildOrder(argv[2], steps, error))
+    {
+        fprintf(stderr, "%s: %s\n", argv[2], error.c_str());
+        return 1;
+    }
+    auto state = make_unique<GameState>();
+    if (!PrepareGame(*state, argv[1], WaveManager::DefaultScripts()))
+    {
+        fprintf(stderr, "%s: can't load map\n", argv[1]);
+        return 1;
+    }
+    state->record_rewind = true;
+    state->NewGame(seed);
+
+    // first time through, the state at every tick that gets checked below
+    const unsigned long long SNAPSHOT_TICK = (unsigned long long)rewind_snapshot_interval * 20;
+    const unsigned long long BEFORE_TICK = SNAPSHOT_TICK - rewind_snapshot_interval - 7; // between two snapshots
+    const unsigned long long AFTER_TICK = SNAPSHOT_TICK + 45;
+    map<unsigned long long, vector<unsigned char>> reference;
+    vector<size_t> nextAt; // build order position before every tick, the steps are input and not in the snapshots
+    size_t next = 0;
+    int skipped = 0;
+    while (state->simTick < AFTER_TICK + 30)
+    {
+        unsigned long long tick = state->simTick;
+        if (tick == BEFORE_TICK || tick == SNAPSHOT_TICK || tick == AFTER_TICK)
+            reference[tick] = StateBytes(*state);
+        nextAt.push_back(next);
+        Step(*state, steps, next, skipped);
+    }
+    if (state->player_health <= 0)
+    {
+        fprintf(stderr, "the game was lost before the checked ticks, pick another build order\n");
+        return 1;
+    }
+
+    bool ok = true;
+    // onto a tick with a snapshot of its own, then play on, which snapshots the same tick again
+    ok &= state->RewindTo(SNAPSHOT_TICK) && Check(*state, SNAPSHOT_TICK, reference, "rewind to snapshot");
+    next = nextAt[SNAPSHOT_TICK];
+    while (state->simTick < AFTER_TICK)
+        Step(*state, steps, next, skipped);
+    ok &= Check(*state, AFTER_TICK, reference, "played on to");
+    // and back again into the ticks before it, replayed from their logged dts
+    ok &= state->RewindTo(BEFORE_TICK) && Check(*state, BEFORE_TICK, reference, "second rewind to");
+    next = nextAt[BEFORE_TICK];
+    while (state->simTick < AFTER_TICK)
+        Step(*state, steps, next, skipped);
+    ok &= Check(*state, AFTER_TICK, reference, "played on again to");
+    printf("%s\n", ok ? "rewind ok" : "REWIND BROKEN");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,520 @@
+/* scenario_farm : long sweeps over maps, build orders and wave sets, one worker process per core
+ * The coordinator reads a sweep file, forks the workers and hands them scenarios one at a time
+ * over a local Unix socket. Every scenario is one game (batch_sim.h), in its own worker process,
+ * so a scenario that crashes (or anything that leaks) only takes that worker down: its scenario
+ * goes back on the queue, and a fresh worker takes its place. A scenario that has taken down
+ * --attempts workers is written down as crashed instead of being tried forever.
+ * Workers also get replaced after --recycle scenarios, so slow leaks never add up.
+ *
+ * Finished results are appended to the results file as they come in and synced to disk every
+ * --checkpoint seconds. Start it again with the same sweep and results file and it picks up
+ * where it left off: whatever is in the results file is done, a half written last line is dropped.
+ * Lines are in the order scenarios finished, the scenario column is the order in the sweep.
+ *
+ * Sweep file (.ozs), plain text:
+ *   # comment
+ *   <map.ozm> <build.ozb> <waves.ozw | -> <first seed> <runs>     - = the built-in waves
+ * Build orders and wave files are loaded once by the coordinator, before the workers fork off it.
+ *
+ * Protocol, one line each way: worker "ready", coordinator "run <scenario>" (or "quit"),
+ * worker "done <scenario> <result csv>", then "ready" again when it wants more.
+ *
+ * make farm && ./build/scenario_farm sweep.ozs results.csv [--workers N] [--socket path] [--checkpoint seconds] [--recycle N] [--attempts N]
+ */
+#include "batch_sim.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+struct Scenario
+{
+    int map;   // into Sweep::maps
+    int build; // into Sweep::builds
+    int waves; // into Sweep::waves
+    unsigned int seed;
+};
+
+// everything the sweep needs, read once by the coordinator, the workers get it with the fork
+struct Sweep
+{
+    vector<string> maps;
+    vector<string> buildPaths;
+    vector<vector<BuildStep>> builds;
+    vector<string> wavePaths; // "-" for the built-in ones
+    vector<shared_ptr<const WaveScripts>> waves;
+    vector<Scenario> scenarios;
+};
+
+// index of path in paths, added (and loaded by load) the first time
+template <typename T, typename Load>
+static int Intern(vector<string> &paths, vector<T> &loaded, const string &path, Load load, string &error)
+{
+    for (size_t i = 0; i < paths.size(); i++)
+        if (paths[i] == path)
+            return (int)i;
+    T value;
+    if (!load(value))
+    {
+        error = path + ": " + error;
+        return -1;
+    }
+    paths.push_back(path);
+    loaded.push_back(std::move(value));
+    return (int)paths.size() - 1;
+}
+
+static bool LoadSweep(const char *path, Sweep &sweep, string &error)
+{
+    ifstream file(path);
+    if (!file)
+    {
+        error = string(path) + ": can't open file";
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    vector<int> mapsChecked;
+    while (getline(file, line))
+    {
+        lineNumber++;
+        istringstream in(line);
+        string mapPath, buildPath, wavePath;
+        if (!(in >> mapPath) || mapPath[0] == '#')
+            continue;
+        unsigned int firstSeed = 0;
+        int runs = 0;
+        if (!(in >> buildPath >> wavePath >> firstSeed >> runs) || runs < 0)
+        {
+            error = string(path) + ": line " + to_string(lineNumber) + ": expected <map> <build> <waves | -> <first seed> <runs>";
+            return false;
+        }
+        Scenario scenario;
+        // a typo in a map path would otherwise quietly become hours of games on the built-in map
+        scenario.map = Intern(sweep.maps, mapsChecked, mapPath, [&](int &) {
+            GameState probe;
+            error = "can't load map";
+            return probe.LoadMap(mapPath.c_str());
+        }, error);
+        scenario.build = Intern(sweep.buildPaths, sweep.builds, buildPath, [&](vector<BuildStep> &steps) { return LoadBuildOrder(buildPath.c_str(), steps, error); }, error);
+        scenario.waves = Intern(sweep.wavePaths, sweep.waves, wavePath, [&](shared_ptr<const WaveScripts> &waves) {
+            waves = wavePath == "-" ? WaveManager::DefaultScripts() : WaveManager::LoadScripts(wavePath.c_str(), error);
+            return waves != nullptr;
+        }, error);
+        if (scenario.map < 0 || scenario.build < 0 || scenario.waves < 0)
+            return false;
+        for (int i = 0; i < runs; i++)
+        {
+            scenario.seed = firstSeed + (unsigned int)i;
+            sweep.scenarios.push_back(scenario);
+        }
+    }
+    return true;
+}
+
+static bool SendLine(int fd, const string &line)
+{
+    string out = line + "\n";
+    size_t sent = 0;
+    while (sent < out.size())
+    {
+        ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// next whole line out of buffer (without the newline), false if there isn't one yet
+static bool TakeLine(string &buffer, string &line)
+{
+    size_t end = buffer.find('\n');
+    if (end == string::npos)
+        return false;
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+// one result as its CSV fields, what a worker sends back
+static string ResultCsv(const RunResult &result)
+{
+    char *text = nullptr;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    WriteResult(out, result);
+    fclose(out);
+    string csv(text, size);
+    free(text);
+    return csv;
+}
+
+// ---- worker ----
+
+static int WorkerMain(const char *socketPath, const Sweep &sweep, int recycleAfter)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+        return 1;
+
+    auto state = make_unique<GameState>();
+    int loadedMap = -1, loadedWaves = -1;
+    string buffer, line;
+    char chunk[4096];
+    for (int played = 0; recycleAfter <= 0 || played < recycleAfter; played++)
+    {
+        if (!SendLine(fd, "ready"))
+            break;
+        while (!TakeLine(buffer, line))
+        {
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return 0; // coordinator's gone, nothing left to do
+            buffer.append(chunk, (size_t)n);
+        }
+        int id = -1;
+        if (sscanf(line.c_str(), "run %d", &id) != 1 || id < 0 || id >= (int)sweep.scenarios.size())
+            break; // "quit"
+        const Scenario &scenario = sweep.scenarios[id];
+        // the map and the waves stay loaded while the scenarios keep asking for the same ones
+        if (scenario.map != loadedMap || scenario.waves != loadedWaves)
+        {
+            PrepareGame(*state, sweep.maps[scenario.map].c_str(), sweep.waves[scenario.waves]);
+            loadedMap = scenario.map;
+            loadedWaves = scenario.waves;
+        }
+        RunResult result;
+        PlayOne(*state, sweep.builds[scenario.build], scenario.seed, result);
+
+        if (!SendLine(fd, "done " + to_string(id) + " " + ResultCsv(result)))
+            break;
+    }
+    close(fd);
+    return 0;
+}
+
+// ---- coordinator ----
+
+struct Connection
+{
+    int fd;
+    string buffer;
+    int scenario = -1; // handed out and not back yet
+    bool waiting = false; // said ready, nothing to give it right now
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/* the results file so far: every scenario on a whole line is done, a line cut off by a crash or a kill is dropped
+ * (the file is cut back to the last whole line), returns how many were done
+ */
+static int ResumeResults(const char *path, int total, vector<char> &done, bool &needsHeader)
+{
+    needsHeader = true;
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return 0;
+    string contents;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        contents.append(chunk, n);
+    fclose(in);
+    size_t whole = contents.rfind('\n');
+    whole = whole == string::npos ? 0 : whole + 1;
+    if (whole != contents.size() && truncate(path, (off_t)whole) != 0)
+        perror(path);
+    int count = 0;
+    size_t start = 0;
+    while (start < whole)
+    {
+        size_t end = contents.find('\n', start);
+        if (start == 0)
+            needsHeader = false; // the first line is the header
+        else
+        {
+            int id = atoi(contents.c_str() + start);
+            if (id >= 0 && id < total && !done[id])
+            {
+                done[id] = 1;
+                count++;
+            }
+        }
+        start = end + 1;
+    }
+    return count;
+}
+
+static void OnStopSignal(int) { stopRequested = 1; }
+
+static pid_t SpawnWorker(int listenFd, const vector<Connection> &connections, const char *socketPath, const Sweep &sweep, int recycleAfter)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // the coordinator's ends of the other workers' sockets, kept open here they'd hide a dead coordinator from them
+        close(listenFd);
+        for (auto &c : connections)
+            close(c.fd);
+        signal(SIGINT, SIG_IGN); // ctrl-c is for the coordinator, it tells the workers to stop
+        signal(SIGTERM, SIG_DFL);
+        _exit(WorkerMain(socketPath, sweep, recycleAfter));
+    }
+    if (pid < 0)
+        perror("fork");
+    return pid;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <sweep.ozs> <results.csv> [--workers N] [--socket path] [--checkpoint seconds] [--recycle N] [--attempts N]\n", argv[0]);
+        return 1;
+    }
+    const char *sweepPath = argv[1];
+    const char *resultsPath = argv[2];
+    int workers = (int)thread::hardware_concurrency();
+    string socketPath = "/tmp/outpostzero-farm-" + to_string(getpid()) + ".sock";
+    double checkpointSeconds = 10.0;
+    int recycleAfter = 500;
+    int maxAttempts = 3;
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--workers"))
+            workers = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--socket"))
+            socketPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--checkpoint"))
+            checkpointSeconds = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--recycle"))
+            recycleAfter = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--attempts"))
+            maxAttempts = atoi(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (workers < 1)
+        workers = 1;
+    if (maxAttempts < 1)
+        maxAttempts = 1;
+
+    Sweep sweep;
+    string error;
+    if (!LoadSweep(sweepPath, sweep, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    int total = (int)sweep.scenarios.size();
+    vector<char> done(total, 0);
+    bool needsHeader;
+    int doneCount = ResumeResults(resultsPath, total, done, needsHeader);
+    FILE *results = fopen(resultsPath, "a");
+    if (!results)
+    {
+        perror(resultsPath);
+        return 1;
+    }
+    if (needsHeader)
+    {
+        fprintf(results, "scenario,map,build,waves,");
+        WriteResultHeader(results);
+        fprintf(results, "\n");
+    }
+    deque<int> queue;
+    for (int i = 0; i < total; i++)
+        if (!done[i])
+            queue.push_back(i);
+    if (doneCount > 0)
+        fprintf(stderr, "resuming: %d of %d scenarios already done\n", doneCount, total);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "%s: socket path too long\n", socketPath.c_str());
+        return 1;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str()); // left over from a coordinator that got killed
+    if (listenFd < 0 || bind(listenFd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 64) < 0)
+    {
+        perror(socketPath.c_str());
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, OnStopSignal);
+    signal(SIGTERM, OnStopSignal);
+
+    vector<int> attempts(total, 0);
+    vector<Connection> connections;
+    int liveWorkers = 0;
+    int crashes = 0;
+    int finishedHere = 0;
+    auto start = chrono::steady_clock::now();
+    auto lastCheckpoint = start;
+
+    auto record = [&](int id, const string &csv) {
+        const Scenario &s = sweep.scenarios[id];
+        fprintf(results, "%d,%s,%s,%s,%s\n", id, sweep.maps[s.map].c_str(), sweep.buildPaths[s.build].c_str(), sweep.wavePaths[s.waves].c_str(), csv.c_str());
+        done[id] = 1;
+        doneCount++;
+        finishedHere++;
+    };
+    auto checkpoint = [&]() {
+        fflush(results);
+        fsync(fileno(results));
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%d / %d scenarios, %.1f runs/s, %d workers, %d crashes\n", doneCount, total, seconds > 0 ? finishedHere / seconds : 0.0, liveWorkers, crashes);
+        lastCheckpoint = chrono::steady_clock::now();
+    };
+    // hands out the next queued scenario, or tells the worker to stop once there's nothing left at all
+    auto handOut = [&](Connection &c) {
+        c.waiting = false;
+        if (!queue.empty() && !stopRequested)
+        {
+            c.scenario = queue.front();
+            queue.pop_front();
+            if (!SendLine(c.fd, "run " + to_string(c.scenario)))
+                c.waiting = false; // it's gone, the hangup gives the scenario back
+        }
+        else if (doneCount == total || stopRequested)
+            SendLine(c.fd, "quit");
+        else
+            c.waiting = true; // others still out, one of them might come back
+    };
+
+    while (doneCount < total || liveWorkers > 0)
+    {
+        // dead workers, crashed or recycled, get replaced while there's work left
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            liveWorkers--;
+            if (WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0))
+                crashes++;
+        }
+        int outstanding = (int)queue.size();
+        for (auto &c : connections)
+            outstanding += c.scenario >= 0;
+        while (!stopRequested && liveWorkers < min(workers, outstanding) && SpawnWorker(listenFd, connections, socketPath.c_str(), sweep, recycleAfter) > 0)
+            liveWorkers++;
+        if (liveWorkers == 0 && (stopRequested || outstanding == 0))
+            break;
+
+        vector<pollfd> fds = {{listenFd, POLLIN, 0}};
+        for (auto &c : connections)
+            fds.push_back({c.fd, POLLIN, 0});
+        // short timeout, so exited workers get reaped and checkpoints happen even when nothing talks
+        int ready = poll(fds.data(), fds.size(), 200);
+        if (ready < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN))
+        {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0)
+                connections.push_back({fd});
+        }
+        for (size_t i = 1; ready > 0 && i < fds.size(); i++)
+        {
+            if (!fds[i].revents)
+                continue;
+            Connection &c = connections[i - 1];
+            char chunk[4096];
+            ssize_t n = read(c.fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+            {
+                // hung up, with a scenario still out means it died on it
+                if (c.scenario >= 0 && !done[c.scenario])
+                {
+                    int id = c.scenario;
+                    if (++attempts[id] >= maxAttempts)
+                    {
+                        RunResult crashed;
+                        crashed.seed = sweep.scenarios[id].seed;
+                        crashed.outcome = "crashed";
+                        record(id, ResultCsv(crashed));
+                        fprintf(stderr, "scenario %d took down %d workers, written down as crashed\n", id, attempts[id]);
+                    }
+                    else
+                        queue.push_front(id);
+                }
+                close(c.fd);
+                c.fd = -1;
+                continue;
+            }
+            c.buffer.append(chunk, (size_t)n);
+            string line;
+            while (TakeLine(c.buffer, line))
+            {
+                int id = -1, offset = 0;
+                if (line == "ready")
+                    handOut(c);
+                else if (sscanf(line.c_str(), "done %d %n", &id, &offset) == 1 && id == c.scenario)
+                {
+                    c.scenario = -1;
+                    if (!done[id])
+                        record(id, line.substr(offset));
+                }
+            }
+        }
+        connections.erase(remove_if(connections.begin(), connections.end(), [](const Connection &c) { return c.fd < 0; }), connections.end());
+        // something came back on the queue (or everything's done), the idle ones get it
+        for (auto &c : connections)
+            if (c.waiting && (!queue.empty() || doneCount == total || stopRequested))
+                handOut(c);
+
+        if (chrono::duration<double>(chrono::steady_clock::now() - lastCheckpoint).count() >= checkpointSeconds)
+            checkpoint();
+    }
+
+    for (auto &c : connections)
+        close(c.fd);
+    while (liveWorkers > 0 && waitpid(-1, nullptr, 0) > 0)
+        liveWorkers--;
+    checkpoint();
+    fclose(results);
+    close(listenFd);
+    unlink(socketPath.c_str());
+    if (doneCount < total)
+    {
+        fprintf(stderr, "stopped with %d scenarios left, run it again with the same results file to go on\n", total - doneCount);
+        return 2;
+    }
+    return 0;
+}
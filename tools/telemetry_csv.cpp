@@ -0,0 +1,77 @@
+/* telemetry_csv : a gameplay telemetry log (.oztl, see Telemetry.h) as CSV, for spreadsheets and scripts
+ * One line per event: tick, event, enemy, turret, id, value
+ * enemy / turret are names and only filled in for the events that have them.
+ * Doesn't need raylib itself, only the headers for the types.
+ *
+ * make telemetry && ./build/telemetry_csv game.oztl [out.csv]
+ */
+#include "StatsManager.h"
+#include "Telemetry.h"
+#include "Types.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+static bool HasEnemy(TelemetryKind kind)
+{
+    return kind == TelemetryKind::SPAWN || kind == TelemetryKind::LEAK || kind == TelemetryKind::KILL;
+}
+static bool HasTurret(TelemetryKind kind)
+{
+    return kind == TelemetryKind::KILL || kind == TelemetryKind::DAMAGE || kind == TelemetryKind::BUILD || kind == TelemetryKind::UPGRADE || kind == TelemetryKind::SELL;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <log.oztl> [out.csv]\n", argv[0]);
+        return 1;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    char magic[4];
+    unsigned int version = 0;
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, TELEMETRY_MAGIC, 4) != 0 || fread(&version, sizeof(version), 1, in) != 1 || version != TELEMETRY_VERSION)
+    {
+        fprintf(stderr, "%s: not a telemetry log (or a different version)\n", argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "tick,event,enemy,turret,id,value\n");
+    // whole records a chunk at a time, logs from long sessions don't have to fit in memory
+    const size_t CHUNK_EVENTS = 1 << 14;
+    vector<unsigned char> chunk(CHUNK_EVENTS * TelemetryEvent::RECORD_BYTES);
+    size_t events = 0;
+    size_t got;
+    while ((got = fread(chunk.data(), TelemetryEvent::RECORD_BYTES, CHUNK_EVENTS, in)) > 0)
+    {
+        BinaryReader reader(chunk.data(), got * TelemetryEvent::RECORD_BYTES);
+        for (size_t i = 0; i < got; i++)
+        {
+            TelemetryEvent event;
+            event.Read(reader);
+            const char *enemy = HasEnemy(event.kind) && event.enemy < ENEMY_TYPE_COUNT ? StatsManager::EnemyName((EnemyType)event.enemy) : "";
+            const char *turret = !HasTurret(event.kind) ? "" : event.turret < TURRET_TYPE_COUNT ? StatsManager::TurretName((TurretType)event.turret) : "none";
+            fprintf(out, "%llu,%s,%s,%s,%u,%g\n", event.tick, TelemetryKindName(event.kind), enemy, turret, event.id, event.value);
+        }
+        events += got;
+    }
+    // a log cut off mid-record (the game was killed) still gives everything before it
+    fclose(in);
+    if (out != stdout)
+        fclose(out);
+    fprintf(stderr, "%zu events\n", events);
+    return 0;
+}